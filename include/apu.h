@@ -5,6 +5,8 @@
 #include "gb_apu/Gb_Apu.h"
 #include "gb_apu/Multi_Buffer.h"
 
+#define APU_WRITE_QUEUE_SIZE 64
+
 class Gameboy;
 
 class APU {
@@ -19,14 +21,38 @@ public:
 
     void setHalfSpeed(bool halfSpeed);
 
+    // Scales the clock rate used when resampling to the output rate; does not affect emulation.
+    void setRateScale(double rateScale);
+
     friend std::istream& operator>>(std::istream& is, APU& apu);
     friend std::ostream& operator<<(std::ostream& os, APU& apu);
 private:
     Gameboy* gameboy;
 
+    bool isSoundEnabled();
+    bool isMultiTrackEnabled();
+    void updateOutputs();
+    void updateChannelOutputs();
+    void readChannels(long samples);
+    void flushWrites();
+
     Stereo_Buffer buffer;
+    Stereo_Buffer channelBuffers[4];
     Gb_Apu apu;
 
     u64 lastSoundCycle;
     bool halfSpeed;
+    double rateScale;
+
+    // With sound disabled the oscillators have no output, so Gb_Apu only keeps
+    // register state, length counters and the frame sequencer running.
+    bool synthEnabled;
+    bool multiTrack;
+
+    // Register writes are queued and applied together, so that runs of writes to one
+    // channel only catch up that channel. This pays off for games that play samples by
+    // rewriting a channel's volume and retriggering it many times a frame. The queue is
+    // flushed on any read, at the end of every frame and when it fills.
+    Gb_Apu::write_t pendingWrites[APU_WRITE_QUEUE_SIZE];
+    u32 pendingWriteCount;
 };
\ No newline at end of file
@@ -1,12 +1,18 @@
 #pragma once
 
+#include <vector>
+
 #include "types.h"
 
 class Gameboy;
+class RomImage;
 
 #define ROM_BANK_SIZE 0x4000
 #define ROM_BANK_MASK 0x3FFF
 
+#define SRAM_BANK_SIZE 0x2000
+#define SRAM_BANK_MASK 0x1FFF
+
 typedef enum : u8 {
     MBC0 = 0,
     MBC1,
@@ -33,12 +39,21 @@ typedef void (Cartridge::*mbcUpdate)();
 class Cartridge {
 public:
     Cartridge(std::istream& romData, u32 romSize);
+    Cartridge(RomImage* image);
     ~Cartridge();
 
     void reset(Gameboy* gameboy);
 
     void load(std::istream& data);
     void save(std::ostream& data);
+    void saveDirty(std::ostream& data);
+
+    void loadBattery(std::istream& data);
+    void saveBattery(std::ostream& data);
+
+    void setSramBuffer(u8* buffer);
+
+    void writeSramPage(u16 addr, u8 val);
 
     friend std::istream& operator>>(std::istream& is, Cartridge& cart);
     friend std::ostream& operator<<(std::ostream& os, const Cartridge& cart);
@@ -79,6 +94,8 @@ public:
         return this->rom[0x0148];
     }
 
+    u64 getRomHash();
+
     inline u16 getRomBanks() {
         return this->totalRomBanks;
     }
@@ -104,14 +121,41 @@ public:
             return nullptr;
         }
 
-        return &this->rom[bank * ROM_BANK_SIZE];
+        return this->romBanks[bank];
+    }
+
+    u8* patchRomBank(u16 bank);
+    void unpatchRomBank(u16 bank);
+
+    inline u8* getSram() {
+        return this->sram;
+    }
+
+    inline u32 getSramSize() {
+        return (u32) (this->totalRamBanks * SRAM_BANK_SIZE);
+    }
+
+    inline bool isSramDirty() {
+        return this->sramDirty != 0;
+    }
+
+    inline u64 getSramDirtyCycle() {
+        return this->sramDirtyCycle;
+    }
+
+    inline u64 getSramWriteCycle() {
+        return this->sramWriteCycle;
     }
 private:
+    void init();
+
     u8 readSram(u16 addr);
     void writeSram(u16 addr, u8 val);
+    void markSramDirty(u32 offset);
 
     void mapRomBank0();
     void mapRomBank1();
+    void mapSramPage(u8 page, u8* block, bool read, bool write);
     void mapSramBank();
     void mapBanks();
 
@@ -208,8 +252,13 @@ private:
 
     Gameboy* gameboy;
 
+    RomImage* image;
     u8* rom;
 
+    // Per-bank pointers into the shared image, or into a private copy once a bank has been patched.
+    std::vector<u8*> romBanks;
+    std::vector<bool> romOverlay;
+
     std::string romTitle;
     u16 totalRomBanks;
     u8 totalRamBanks;
@@ -224,6 +273,14 @@ private:
     mbcUpdate updateFunc;
 
     u8* sram;
+    bool sramExternal;
+
+    // Dirty tracking, one bit per 4KB SRAM page.
+    u8* sramPages[2];
+    bool sramPageWrite[2];
+    u32 sramDirty;
+    u64 sramDirtyCycle;
+    u64 sramWriteCycle;
 
     // General
     u16 romBank0;
@@ -4,11 +4,12 @@
 
 #include <vector>
 
+class Cartridge;
 class Gameboy;
 
 class CheatEngine {
 public:
-    CheatEngine(Gameboy* g) : gameboy(g) {}
+    CheatEngine(Gameboy* g) : gameboy(g), romPatchedCartridge(nullptr), romPatchesDirty(false), patchesDirty(true), patchGeneration(0) {}
 
     void update();
 
@@ -48,8 +49,6 @@ private:
             u8 compare; /* For GameGenie codes */
             u8 bank;    /* For GameShark codes */
         };
-        std::vector<u16> patchedBanks;  /* For GameGenie codes */
-        std::vector<u8> patchedValues; /* For GameGenie codes */
     } CheatLine;
 
     typedef struct {
@@ -60,9 +59,42 @@ private:
         std::vector<CheatLine> lines;
     } Cheat;
 
+    // A GameShark write resolved against the current memory map. Writes that can't be
+    // resolved to plain memory, such as to IO registers, go through the MMU instead.
+    typedef struct {
+        u8* dst;
+        u16 address;
+        u8 data;
+    } CheatPatch;
+
+    // A Game Genie code, indexed by its offset within the banks it applies to.
+    typedef struct {
+        u16 offset;
+        u8 data;
+        u8 compare;
+        bool hasCompare;
+    } RomPatch;
+
+    // A ROM byte overwritten by a Game Genie code, and what was there before.
+    typedef struct {
+        u16 bank;
+        u16 offset;
+        u8 value;
+    } RomUndo;
+
     Gameboy* gameboy;
 
     std::vector<Cheat> cheats;
 
+    std::vector<RomUndo> romUndo;
+    Cartridge* romPatchedCartridge;
+    bool romPatchesDirty;
+
+    std::vector<CheatPatch> patches;
+    bool patchesDirty;
+    u32 patchGeneration;
+
     void parseLine(Cheat& cheat, const std::string& line);
+    void compilePatches();
+    void applyRomPatches();
 };
\ No newline at end of file
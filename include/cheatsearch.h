@@ -0,0 +1,87 @@
+#pragma once
+
+#include "types.h"
+
+#include <vector>
+
+class Gameboy;
+
+typedef enum {
+    SEARCH_EQUAL_TO,
+    SEARCH_NOT_EQUAL_TO,
+    SEARCH_CHANGED,
+    SEARCH_UNCHANGED,
+    SEARCH_INCREASED,
+    SEARCH_DECREASED,
+    SEARCH_INCREASED_BY,
+    SEARCH_DECREASED_BY,
+
+    NUM_SEARCH_RELATIONS
+} SearchRelation;
+
+// Finds the RAM addresses holding a value by narrowing down candidates over successive
+// snapshots of WRAM, HRAM and cartridge SRAM. Candidates become GameShark codes.
+class CheatSearch {
+public:
+    CheatSearch(Gameboy* g) : gameboy(g), numCandidates(0) {}
+
+    void start();
+    void clear();
+
+    // Keeps the candidates whose current value relates to the previous snapshot, or to value,
+    // as given, then takes a new snapshot.
+    void filter(SearchRelation relation, u8 value);
+
+    inline bool isActive() {
+        return !this->snapshot.empty();
+    }
+
+    inline u32 getNumCandidates() {
+        return this->numCandidates;
+    }
+
+    // Returns the position of the index'th remaining candidate, in address order.
+    u32 getCandidate(u32 index);
+
+    u16 getAddress(u32 position);
+    u8 getBank(u32 position);
+    u8 getValue(u32 position);
+
+    // Returns a GameShark code that keeps the candidate at value.
+    const std::string getCode(u32 position, u8 value);
+
+    static const std::string getRelationName(SearchRelation relation);
+private:
+    typedef enum {
+        SEARCH_REGION_MAPPED,
+        SEARCH_REGION_WRAM,
+        SEARCH_REGION_SRAM
+    } SearchRegionType;
+
+    typedef struct {
+        SearchRegionType type;
+        u8 index;
+
+        u32 offset;
+        u32 size;
+
+        u16 address;
+        u8 bank;
+    } SearchRegion;
+
+    Gameboy* gameboy;
+
+    std::vector<SearchRegion> regions;
+
+    // One byte per address, padded to whole 16 byte blocks.
+    std::vector<u8> snapshot;
+
+    // One bit per address, one word per block.
+    std::vector<u16> candidates;
+    u32 numCandidates;
+
+    void addRegion(SearchRegionType type, u8 index, u32 size, u16 address, u8 bank);
+    const u8* getRegionData(const SearchRegion& region);
+    const SearchRegion* findRegion(u32 position);
+    bool capture(std::vector<u8>& out);
+};
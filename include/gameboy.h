@@ -4,6 +4,7 @@
 
 #include "apu.h"
 #include "cheatengine.h"
+#include "cheatsearch.h"
 #include "cpu.h"
 #include "mmu.h"
 #include "ppu.h"
@@ -81,6 +82,8 @@ typedef struct {
     void (*readTilt)(u16* x, u16* y);
     void (*setRumble)(bool rumble);
 
+    u64 (*getTime)();
+
     u32* (*getCameraImage)();
 
     void (*printImage)(bool appending, u8* buf, int size, u8 palette);
@@ -93,6 +96,10 @@ typedef struct {
     u32* audioBuffer;
     u32 audioSamples;
     u32 audioSampleRate;
+
+    // Optional, audioSamples long each. When all are set, each channel is also synthesised on
+    // its own and written here unmuted, sample for sample alongside audioBuffer.
+    u32* channelAudioBuffers[4];
 } GameboySettings;
 
 class Gameboy {
@@ -126,6 +133,7 @@ public:
     Timer timer;
     Serial serial;
     CheatEngine cheatEngine;
+    CheatSearch cheatSearch;
 
     GBMode gbMode;
 
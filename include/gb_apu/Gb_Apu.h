@@ -37,6 +37,20 @@ public:
 	// Emulates CPU write of data to addr at specified time.
 	void write_register( s32 time, unsigned addr, int data );
 	
+	// A CPU write queued for later, for callers that batch writes up.
+	struct write_t
+	{
+		s32 time;
+		u16 addr;
+		u8  data;
+	};
+	
+	// Emulates a run of CPU writes, which must be in time order. Produces the same
+	// result as calling write_register() for each, but a write to a channel's
+	// registers doesn't catch up the other square and wave channels, as long as no
+	// frame sequencer step or master register write comes in between.
+	void write_registers( write_t const* writes, int count );
+	
 	// Emulates CPU read from addr at specified time.
 	int read_register( s32 time, unsigned addr );
 	
@@ -53,6 +67,10 @@ public:
 	// emulation accuracy, since the clicks are authentic.
 	void reduce_clicks( bool reduce = true );
 	
+	// Sets buffer(s) that also receive channel chan's sound, ignoring the per-channel
+	// enable options. Pass NULL to stop.
+	void set_stem_output( Blip_Buffer* center, Blip_Buffer* left, Blip_Buffer* right, int chan );
+	
 	// Sets treble equalization.
 	void treble_eq( blip_eq_t const& );
 	
@@ -118,6 +136,8 @@ private:
 	void synth_volume( int );
 	void run_until_( s32 );
 	void run_until( s32 );
+	void run_osc( int index, s32 time, s32 end_time );
+	int reg_osc( unsigned addr ) const;
 	void silence_osc( Gb_Osc& );
 	void write_osc( int index, int reg, int old_data, int data );
 	const char* save_load( gb_apu_state_t*, bool save );
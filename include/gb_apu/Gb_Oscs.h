@@ -30,6 +30,8 @@ public:
 	u8*             regs;       // osc's 5 registers
 	int             dac_off_amp;// amplitude when DAC is off
 	int             last_amp;   // current amplitude in Blip_Buffer
+	Blip_Buffer*    stem_outputs [4];// NULL, right, left, center; unmuted copy of this osc alone
+	Blip_Buffer*    stem_output;// where to output the copy, if anywhere
 	typedef Blip_Synth<blip_good_quality,1> Good_Synth;
 	typedef Blip_Synth<blip_med_quality ,1> Med_Synth;
 	Good_Synth const* good_synth;
@@ -34,6 +34,8 @@ public:
 private:
     void mix_mono  ( s16* out, int pair_count );
     void mix_stereo( s16* out, int pair_count );
+    // Portable version of mix_stereo(); the vector versions must match it bit for bit.
+    void mix_stereo_scalar( s16* out, int pair_count );
 };
 
 // Uses three buffers (one for center) and outputs stereo sample pairs.
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+
+#include "types.h"
+
+#include "serial.h"
+
+class Gameboy;
+
+// How far, in cycles, either side may run ahead of the other before it waits.
+#define LINK_QUANTUM_CYCLES 1024
+
+// Connects the serial ports of two GameBoys, each running on its own thread.
+// The two sides run freely within LINK_QUANTUM_CYCLES of each other. A transfer only waits when
+// the internally clocked side finishes shifting a byte, until the other side's clock reaches the
+// cycle the byte was sent at and it has swapped in its own.
+// Connect, disconnect and destroy the cable only while neither side is running.
+class LinkCable {
+public:
+    LinkCable();
+    ~LinkCable();
+
+    void connect(Gameboy* first, Gameboy* second);
+    void disconnect();
+private:
+    // One end of the cable, plugged into the serial port of a side.
+    class Port : public SerialLink {
+    public:
+        u64 sync(u64 cycle);
+        u8 transfer(u64 cycle, u8 val);
+        bool poll(u64 cycle, u8 val, u8* received);
+
+        LinkCable* cable;
+        u8 side;
+    };
+
+    // Keeps a side within the quantum of the other, and shifts in any byte sent to it.
+    void sync(u8 side, u64 cycle);
+    // Swaps a byte with the other side, returning 0xFF if nothing is connected to receive it.
+    u8 transfer(u8 side, u64 cycle, u8 data);
+    // Swaps a byte sent to a side that is listening for one.
+    bool poll(u8 side, u64 cycle, u8 data, u8* received);
+
+    u64 updateClock(u8 side, u64 cycle);
+    void receive(u8 side, u64 clock);
+
+    Port ports[2];
+    Gameboy* gameboys[2];
+    std::atomic<bool> connected;
+
+    // Each side's clock only moves forward, even when its CPU is reset or loads a state.
+    u64 lastCycles[2];
+    u64 clockOffsets[2];
+    std::atomic<u64> clocks[2];
+
+    // Mailbox of each side, for a byte sent to it and its reply.
+    std::atomic<u8> mailStates[2];
+    u64 mailClocks[2];
+    u8 mailData[2];
+    u8 mailReplies[2];
+};
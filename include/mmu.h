@@ -100,11 +100,38 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const MMU& mmu);
 
     inline void mapPage(u8 page, u8* block, bool read, bool write) {
+        if(this->pageWrite[page & 0xF] != write || (write && this->pages[page & 0xF] != block)) {
+            this->mapGeneration++;
+        }
+
         this->pages[page & 0xF] = block;
         this->pageRead[page & 0xF] = read;
         this->pageWrite[page & 0xF] = write;
     }
 
+    // Returns the memory a write to addr lands in, or nullptr if the write has side effects.
+    // Only valid until the writable memory map next changes; see getMapGeneration.
+    inline u8* getWritePointer(u16 addr) {
+        u8 area = (u8) (addr >> 12);
+        if(this->pageWrite[area]) {
+            return &this->pages[area][addr & 0xFFF];
+        }
+
+        if(addr >= 0xFF80 && addr < IE) {
+            return &this->hram[addr & 0xFF];
+        }
+
+        return nullptr;
+    }
+
+    inline u8* getWramBank(u8 bank) {
+        return this->wram[bank & 0x7];
+    }
+
+    inline u32 getMapGeneration() {
+        return this->mapGeneration;
+    }
+
     inline u8 readIO(u16 addr) {
         return this->hram[addr & 0xFF];
     }
@@ -130,4 +157,6 @@ private:
 
     bool biosMapped;
     bool useRealBios;
+
+    u32 mapGeneration;
 };
\ No newline at end of file
@@ -7,4 +7,11 @@ void audioCleanup();
 
 u32 audioGetSampleRate();
 
+// Correction to apply to the emulated clock rate when resampling, to keep the output queue steady.
+double audioGetRateScale();
+
+// Blocks until the output queue is ready for another frame of samples. Returns false if
+// the device cannot be used to pace emulation.
+bool audioWaitForFrame();
+
 void audioPlay(u32* buffer, long samples);
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "types.h"
+
+#define CAMERA_IMAGE_WIDTH 128
+#define CAMERA_IMAGE_HEIGHT 120
+
+// Stand-in frame sources for the Game Boy Camera, for hosts without a camera of their own.
+typedef enum {
+    CAMERA_SOURCE_OFF = 0,
+    CAMERA_SOURCE_IMAGE,
+    CAMERA_SOURCE_PATTERN
+} CameraSource;
+
+bool cameraSetSource(CameraSource source, const std::string& imagePath);
+
+// Returns the current frame in the layout expected by GameboySettings::getCameraImage, or nullptr if off.
+u32* cameraGetImage();
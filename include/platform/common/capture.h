@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vector>
+
+#include "types.h"
+
+// Each audio path gets its own WAV. The first is the mixed sound; any others are extra tracks, such as per-channel stems.
+bool captureStart(const std::string& videoPath, const std::vector<std::string>& audioPaths, u32 sampleRate);
+void captureStop();
+
+bool captureIsRecording();
+u32 captureGetDroppedFrames();
+
+// audio holds one buffer per audio path, each samples long.
+void captureFrame(const u32* frame, u32 pitch, const u32* const* audio, long samples);
@@ -50,6 +50,41 @@
 #define GAMEBOY_GBA_MODE 2
 #define GAMEBOY_BIOS 3
 #define GAMEBOY_GB_PRINTER 4
+#define GAMEBOY_AUTO_SAVE 5
+
+#if defined(BACKEND_SDL) && !defined(WIN32)
+#define GAMEBOY_MAPPED_SAVES 6
+#define GAMEBOY_MAPPED_ROMS 7
+
+#define MAPPED_SAVES_OFF 0
+#define MAPPED_SAVES_ON 1
+
+#define MAPPED_ROMS_OFF 0
+#define MAPPED_ROMS_ON 1
+#endif
+
+#ifdef BACKEND_SDL
+#ifdef GAMEBOY_MAPPED_SAVES
+#define GAMEBOY_CAMERA_SOURCE 8
+#else
+#define GAMEBOY_CAMERA_SOURCE 6
+#endif
+
+#define GAMEBOY_CAMERA_IMAGE_PATH 0
+#endif
+
+#if defined(BACKEND_SDL) && !defined(WIN32)
+#define GAMEBOY_LINK_CABLE 9
+#define GAMEBOY_LINK_TRANSPORT 10
+
+#define LINK_CABLE_OFF 0
+#define LINK_CABLE_HOST 1
+#define LINK_CABLE_JOIN 2
+#define LINK_CABLE_LOCAL 3
+
+#define LINK_TRANSPORT_LOCAL 0
+#define LINK_TRANSPORT_TCP 1
+#endif
 
 #define GB_PRINTER_OFF 0
 #define GB_PRINTER_ON 1
@@ -68,6 +103,13 @@
 #define BIOS_OFF 0
 #define BIOS_ON 1
 
+#define AUTO_SAVE_OFF 0
+#define AUTO_SAVE_ON 1
+
+#define CAMERA_SOURCE_OPTION_OFF 0
+#define CAMERA_SOURCE_OPTION_IMAGE 1
+#define CAMERA_SOURCE_OPTION_PATTERN 2
+
 /* Display */
 
 #define DISPLAY_SCALING_MODE 0
@@ -79,6 +121,10 @@
 #define DISPLAY_CUSTOM_BORDERS 6
 #define DISPLAY_CUSTOM_BORDERS_SCALING 7
 
+#ifdef BACKEND_SDL
+#define DISPLAY_FRAME_PACING 8
+#endif
+
 #define DISPLAY_CUSTOM_BORDER_PATH 0
 
 #define SCALING_MODE_OFF 0
@@ -123,6 +169,10 @@
 #define CUSTOM_BORDERS_SCALING_PRE_SCALED 0
 #define CUSTOM_BORDERS_SCALING_SCALE_BASE 1
 
+#define FRAME_PACING_TIMER 0
+#define FRAME_PACING_AUDIO 1
+#define FRAME_PACING_VSYNC 2
+
 /* Sound */
 
 #define SOUND_MASTER 0
@@ -130,10 +180,23 @@
 #define SOUND_CHANNEL_2 2
 #define SOUND_CHANNEL_3 3
 #define SOUND_CHANNEL_4 4
+#define SOUND_CAPTURE_CHANNELS 5
+
+#ifdef BACKEND_SDL
+#define SOUND_OUTPUT_RATE 6
+#define SOUND_INTERNAL_RATE 7
+#endif
 
 #define SOUND_OFF 0
 #define SOUND_ON 1
 
+// "Device" for the output rate, "Off" for the internal rate.
+#define SAMPLE_RATE_AUTO 0
+#define SAMPLE_RATE_32768 1
+#define SAMPLE_RATE_44100 2
+#define SAMPLE_RATE_48000 3
+#define SAMPLE_RATE_96000 4
+
 struct KeyConfig {
     std::string name;
     u8 funcKeys[512];
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+
+typedef struct {
+    std::string name;
+    u32 directory; // Index into the list of directories being scanned.
+    bool isDirectory;
+} DirScanEntry;
+
+// Lists directories on a background thread, handing entries back in batches as they are read.
+// Listings are cached by directory modification time, so revisiting a directory that hasn't
+// changed costs a single stat, even in a later session.
+class DirScanner {
+public:
+    DirScanner();
+    ~DirScanner();
+
+    // Scans each directory in turn, abandoning any scan already in progress.
+    void start(const std::vector<std::string>& directories);
+    void stop();
+
+    // Moves any entries read since the last call into entries. Returns whether the scan has finished.
+    bool poll(std::vector<DirScanEntry>& entries);
+private:
+    void run(std::vector<std::string> directories);
+    void publish(std::vector<DirScanEntry>& batch);
+
+    std::thread thread;
+    std::atomic<bool> cancel;
+
+    std::mutex mutex;
+    std::vector<DirScanEntry> results;
+    bool finished;
+};
+
+// Loads and saves the listing cache, which lives next to the ROM index file.
+void dirScannerLoadCache();
+void dirScannerSaveCache();
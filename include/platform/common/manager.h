@@ -15,12 +15,24 @@ bool mgrGetFastForward();
 
 void mgrRefreshPalette();
 void mgrRefreshBorder();
+void mgrRefreshPacing();
+void mgrRefreshAudio();
+void mgrRefreshCamera();
+void mgrRefreshLink();
 
 bool mgrStateExists(int stateNum);
 bool mgrLoadState(int stateNum);
 bool mgrSaveState(int stateNum);
 void mgrDeleteState(int stateNum);
 
+bool mgrMovieExists();
+bool mgrRecordMovie(bool powerOn);
+bool mgrPlayMovie();
+void mgrStopMovie();
+
+bool mgrStartCapture();
+void mgrStopCapture();
+
 void mgrUnloadRom(bool save = true, bool exiting = false);
 void mgrReset();
 
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "types.h"
+
+#include "menu.h"
+
+#include "cheatsearch.h"
+
+class CheatSearchMenu : public Menu {
+public:
+    bool processInput(UIKey key, u32 width, u32 height);
+    void draw(u32 width, u32 height);
+private:
+    void addCandidateCheat(u32 index);
+
+    SearchRelation relation = SEARCH_EQUAL_TO;
+    u8 value = 0;
+
+    u32 selection = 0;
+    u32 scrollY = 0;
+
+    std::string message;
+};
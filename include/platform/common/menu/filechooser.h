@@ -3,8 +3,10 @@
 #include "types.h"
 
 #include "menu.h"
+#include "platform/common/dirscanner.h"
 
 #include <functional>
+#include <unordered_set>
 #include <vector>
 
 class FileChooser : public Menu {
@@ -13,6 +15,7 @@ public:
 
     bool processInput(UIKey key, u32 width, u32 height);
     void draw(u32 width, u32 height);
+    bool update();
 private:
     typedef struct {
         std::string name;
@@ -26,6 +29,7 @@ private:
     static bool compareFiles(FileEntry &a, FileEntry &b);
 
     void refreshContents();
+    void addEntries(const std::vector<DirScanEntry>& entries);
 
     std::function<void(bool, const std::string&)> finished;
     std::string directory;
@@ -34,9 +38,20 @@ private:
 
     std::vector<FileEntry> files;
 
+    DirScanner scanner;
+    bool scanning = false;
+    u32 stateSource = 0;
+    u32 contentsSource = 0;
+    std::unordered_set<std::string> states;
+
     u32 selection = 0;
     u32 scrollY = 0;
     u32 filesPerPage = 24;
+    bool selectionMoved = false;
+
+    bool showRomInfo = false;
+    bool romInfoPending = false;
+    u32 romIndexVersion = 0;
 
     std::string initialSelection = "";
 };
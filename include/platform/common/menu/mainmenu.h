@@ -22,6 +22,12 @@ private:
     void saveState();
     void loadState();
     void deleteState();
+    void recordMovie();
+    void recordMovieFromReset();
+    void playMovie();
+    void stopMovie();
+    void startCapture();
+    void stopCapture();
     void romInfo();
     void inputSettings();
     void manageCheats();
@@ -51,6 +57,12 @@ private:
             {"Save State", &MainMenu::saveState, false},
             {"Load State", &MainMenu::loadState, false},
             {"Delete State", &MainMenu::deleteState, false},
+            {"Record Movie", &MainMenu::recordMovie, false},
+            {"Record From Reset", &MainMenu::recordMovieFromReset, false},
+            {"Play Movie", &MainMenu::playMovie, false},
+            {"Stop Movie", &MainMenu::stopMovie, false},
+            {"Start Capture", &MainMenu::startCapture, false},
+            {"Stop Capture", &MainMenu::stopCapture, false},
             {"ROM Info", &MainMenu::romInfo, false},
             {"Input Settings", &MainMenu::inputSettings, true},
             {"Manage Cheats", &MainMenu::manageCheats, false},
@@ -12,6 +12,11 @@ public:
     // Returns whether or not a redraw is needed.
     virtual bool processInput(UIKey key, u32 width, u32 height) = 0;
     virtual void draw(u32 width, u32 height) = 0;
+
+    // Called once per frame while on top of the stack. Returns whether or not a redraw is needed.
+    virtual bool update() {
+        return false;
+    }
 };
 
 bool menuIsVisible();
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "types.h"
+
+class Gameboy;
+
+bool movieRecord(Gameboy* gameboy, const std::string& path, bool powerOn);
+bool moviePlay(Gameboy* gameboy, const std::string& path);
+void movieStop();
+
+bool movieIsRecording();
+bool movieIsPlaying();
+
+// Records or replaces the state of each SGB controller for this frame.
+void movieUpdate(u8* buttons);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "types.h"
+
+class Gameboy;
+
+typedef enum {
+    NETLINK_TRANSPORT_LOCAL = 0,
+    NETLINK_TRANSPORT_TCP
+} NetlinkTransport;
+
+// Links the GameBoy's serial port to another GameYob process, either hosting the link or joining one.
+bool netlinkStart(Gameboy* gameboy, bool host, NetlinkTransport transport);
+void netlinkStop();
+
+bool netlinkIsStarted();
+bool netlinkIsConnected();
+
+// Call around every emulated frame. Internally clocked transfers don't wait on the network; they
+// assume the peer will answer with the byte it sent last, and netlinkEndFrame rolls the GameBoy
+// back and replays the frames since if it didn't.
+void netlinkBeginFrame(const u8* buttons);
+void netlinkEndFrame();
+
+// Forgets any pending speculation, for when the GameBoy's state is replaced from outside.
+void netlinkResync();
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "types.h"
+
+// Queues a band of printer output to be written to "<basePath>-<n>.bmp". Appended bands
+// continue the current print; anything else starts the next free file.
+bool printoutBand(const std::string& basePath, bool appending, const u8* buf, int size, u8 palette);
+
+// Writes out everything queued so far and closes the current print.
+void printoutStop();
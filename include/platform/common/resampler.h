@@ -0,0 +1,14 @@
+#pragma once
+
+#include "types.h"
+
+// Converts interleaved stereo s16 samples from one rate to another using a windowed-sinc
+// polyphase filter. Only one stream is resampled at a time.
+void resamplerInit(u32 inRate, u32 outRate);
+void resamplerReset();
+
+bool resamplerIsActive();
+
+// Returns the number of output samples written. out should have room for the input's
+// length scaled by the rate ratio, plus one; output past maxOut is dropped.
+long resamplerProcess(const u32* in, long inSamples, u32* out, long maxOut);
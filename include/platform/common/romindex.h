@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "types.h"
+
+#define ROM_INDEX_THUMBNAIL_WIDTH 40
+#define ROM_INDEX_THUMBNAIL_HEIGHT 36
+
+typedef struct {
+    std::string title;
+    u8 cgbFlag;
+    u8 sgbFlag;
+    u8 rawMBC;
+    u8 rawRomSize;
+    u8 rawRamSize;
+    u32 crc32;
+
+    // Last frame shown before the ROM was unloaded, in screen buffer format. Empty if it has never been played.
+    std::vector<u32> thumbnail;
+} RomIndexEntry;
+
+// Loads and saves the index file, which lives next to the configuration file.
+void romIndexLoad();
+void romIndexSave();
+
+// Queues a ROM to be indexed in the background. ROMs whose size and modification time haven't changed are skipped.
+void romIndexQueue(const std::string& path);
+bool romIndexLookup(const std::string& path, RomIndexEntry* entry);
+
+// Stores a downscaled copy of a GameBoy frame as the ROM's thumbnail.
+void romIndexSetThumbnail(const std::string& path, const u32* frame, u32 pitch);
+
+// Changes whenever an entry is added or updated.
+u32 romIndexGetVersion();
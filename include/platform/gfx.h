@@ -11,3 +11,6 @@ u32 gfxGetScreenPitch();
 void gfxLoadBorder(u8* imgData, int imgWidth, int imgHeight);
 
 void gfxDrawScreen();
+
+// Makes gfxDrawScreen wait for vertical blank. Returns false if this isn't supported.
+bool gfxSetVsync(bool vsync);
@@ -27,6 +27,8 @@ enum {
     NUM_FUNC_KEYS = 18
 };
 
+#define INPUT_MAX_PLAYERS 4
+
 void inputInit();
 void inputCleanup();
 
@@ -36,6 +38,9 @@ bool inputKeyHeld(u32 key);
 bool inputKeyPressed(u32 key);
 void inputReleaseAll();
 
+// Player 0 is the main input above; players 1 and up are any extra controllers, as of the last inputUpdate.
+bool inputPlayerKeyHeld(u32 player, u32 key);
+
 void inputGetMotionSensor(u16* x, u16* y);
 
 void inputSetRumble(bool rumble);
@@ -69,6 +69,7 @@ private:
     void updateLineSprites();
 
     void updateScanline();
+    void loadLinePalettes(u8 scanline);
     void drawPixel(u8 x, u8 y);
     void drawScanline(u8 scanline);
 
@@ -97,4 +98,7 @@ private:
     TileLine currTileLines[2];
     SpriteLine currSpriteLines[10];
     u8 currSprites;
+
+    // Palette offset of each pixel on the line being drawn; filled from the SGB palette runs.
+    u8 linePalettes[GB_SCREEN_WIDTH];
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iosfwd>
+
+#include "types.h"
+
+typedef void (*romImageFree)(u8* data, u32 size);
+
+// Identifies a mapped ROM file without reading it.
+typedef struct {
+    u64 device;
+    u64 inode;
+    s64 mtime;
+} RomFileId;
+
+// Immutable ROM contents, shared between every cartridge loaded from the same data.
+// Streamed images are looked up by a hash of their contents and compared in full, and mapped
+// ones by the file they were mapped from, so their pages are only read when used. Images are
+// reference counted; per-instance changes such as cheat patches belong in the cartridge, not here.
+class RomImage {
+public:
+    static RomImage* acquire(std::istream& romData, u32 romSize);
+    static RomImage* acquire(u8* romData, u32 romSize, romImageFree freeFunc, const RomFileId& fileId);
+
+    void retain();
+    void release();
+
+    inline u8* getData() {
+        return this->data;
+    }
+
+    inline u32 getSize() {
+        return this->size;
+    }
+
+    // Computed on first use for mapped images.
+    u64 getHash();
+private:
+    RomImage(u8* data, u32 size, u32 rawSize, romImageFree freeFunc);
+    ~RomImage();
+
+    static u32 getRoundedSize(u32 romSize);
+    static u64 hashData(const u8* data, u32 size);
+    static void fixup(u8* data, u32 romSize, u32 roundedSize);
+
+    u8* data;
+    u32 size;
+    u32 rawSize;
+
+    bool hashed;
+    u64 hash;
+
+    bool mapped;
+    RomFileId fileId;
+
+    u32 refs;
+    romImageFree freeFunc;
+};
@@ -2,6 +2,25 @@
 
 #include "types.h"
 
+// The other end of the serial port. Every link, in-process or over a socket, is driven through this.
+// All calls come from the thread running the GameBoy the link is attached to.
+class SerialLink {
+public:
+    virtual ~SerialLink() {
+    }
+
+    // Called on every serial update. Returns the cycle to be called again by, or 0 if it doesn't matter.
+    virtual u64 sync(u64 cycle) {
+        return 0;
+    }
+
+    // Swaps a byte with the other end when the internal clock finishes a transfer.
+    virtual u8 transfer(u64 cycle, u8 val) = 0;
+    // Asked while waiting on an external clock. Once the other end has clocked a byte in, swaps it
+    // for val and returns true.
+    virtual bool poll(u64 cycle, u8 val, u8* received) = 0;
+};
+
 class Serial {
 public:
     Serial(Gameboy* gameboy);
@@ -11,6 +30,10 @@ public:
 
     void write(u16 addr, u8 val);
 
+    void setLink(SerialLink* link);
+    // Shifts in a byte clocked by the other end outside of a poll, returning the one shifted out.
+    u8 linkReceive(u8 val);
+
     friend std::istream& operator>>(std::istream& is, Serial& serial);
     friend std::ostream& operator<<(std::ostream& os, const Serial& serial);
 private:
@@ -18,6 +41,8 @@ private:
 
     Printer printer;
 
+    SerialLink* link;
+
     u64 nextSerialInternalCycle;
     u64 nextSerialExternalCycle;
 };
\ No newline at end of file
@@ -2,8 +2,25 @@
 
 #include "types.h"
 
+#include "ppu.h"
+
 class Gameboy;
 
+#define SGB_BORDER_TILES_X (GB_FRAME_WIDTH / 8)
+#define SGB_BORDER_TILES_Y (GB_FRAME_HEIGHT / 8)
+
+#define SGB_MAX_CONTROLLERS 4
+
+#define SGB_MAP_WIDTH (GB_SCREEN_WIDTH / 8)
+#define SGB_MAP_HEIGHT (GB_SCREEN_HEIGHT / 8)
+
+// A horizontal span of screen pixels sharing one palette.
+typedef struct {
+    u8 x;
+    u8 width;
+    u8 palette;
+} SgbPaletteRun;
+
 class SGB {
 public:
     SGB(Gameboy* gameboy);
@@ -22,11 +39,19 @@ public:
         return this->mask;
     }
 
-    u8* getPaletteMap() {
-        return this->paletteMap;
-    }
+    const SgbPaletteRun* getPaletteRuns(u8 scanline, u8* count);
+
+    // Redraws the whole border. The border is only drawn when it changes, so this must be
+    // called whenever the frame buffer is cleared or replaced.
+    void invalidateBorder();
 private:
+    void invalidatePaletteRuns();
+
     void refreshBg();
+    void decodeBgTile(u8 tile);
+    void loadBgPalette(u8 palette);
+    void markBgTiles(const bool* tiles, const bool* palettes);
+    void drawBgCell(u8 cellX, u8 cellY, u32 color0);
 
     void loadAttrFile(u8 index);
 
@@ -91,7 +116,7 @@ private:
         };
     } cmdData;
 
-    u8 controllers[4];
+    u8 controllers[SGB_MAX_CONTROLLERS];
     u8 numControllers;
     u8 selectedController; // Which controller is being observed
     u8 buttonsChecked;
@@ -103,6 +128,17 @@ private:
     u8 bgTiles[0x2000];
     u8 bgMap[0x1000];
 
+    // Decoded border data, rebuilt from the above and not saved in states.
+    u8 bgPixels[0x100][8 * 8];
+    u32 bgPalettes[4][16];
+    u32 bgColor0;
+    u32 bgDirty[SGB_BORDER_TILES_Y]; // One bit per map cell that needs redrawing.
+
     u8 mask;
-    u8 paletteMap[20 * 18];
+    u8 paletteMap[SGB_MAP_WIDTH * SGB_MAP_HEIGHT];
+
+    // Palette map compressed into runs for each row of tiles, rebuilt as rows are marked dirty.
+    SgbPaletteRun paletteRuns[SGB_MAP_HEIGHT][SGB_MAP_WIDTH];
+    u8 paletteRunCounts[SGB_MAP_HEIGHT];
+    u32 paletteRowsDirty;
 };
\ No newline at end of file
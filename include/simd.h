@@ -0,0 +1,13 @@
+#pragma once
+
+// Picks the vector instruction set for the hand-vectorised loops. Each of those keeps a
+// portable version for targets with neither; define NO_SIMD to build only the portable versions.
+#ifndef NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
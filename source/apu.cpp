@@ -11,16 +11,18 @@
 
 APU::APU(Gameboy* gameboy) : apu(gameboy) {
     this->gameboy = gameboy;
+    this->rateScale = 1;
 }
 
 void APU::reset() {
     this->buffer.set_sample_rate((long) this->gameboy->settings.audioSampleRate);
-    this->buffer.clock_rate(CYCLES_PER_SECOND);
-    this->buffer.clear();
+    this->buffer.clock_rate((long) (CYCLES_PER_SECOND * this->rateScale));
 
-    this->apu.set_output(this->buffer.center(), this->buffer.left(), this->buffer.right());
+    this->updateOutputs();
     this->apu.reset();
 
+    this->pendingWriteCount = 0;
+
     this->lastSoundCycle = 0;
     this->halfSpeed = false;
 }
@@ -29,21 +31,44 @@ void APU::update() {
     if(this->gameboy->cpu.getCycle() >= this->lastSoundCycle + (CYCLES_PER_FRAME << this->halfSpeed)) {
         u32 cycles = (u32) (this->gameboy->cpu.getCycle() - this->lastSoundCycle) >> this->halfSpeed;
 
+        this->flushWrites();
         this->apu.end_frame(cycles);
-        this->buffer.end_frame(cycles);
+        if(this->synthEnabled) {
+            this->buffer.end_frame(cycles);
+        }
+
+        if(this->multiTrack) {
+            for(int i = 0; i < 4; i++) {
+                this->channelBuffers[i].end_frame(cycles);
+            }
+        }
 
         this->lastSoundCycle = this->gameboy->cpu.getCycle();
 
-        if(this->gameboy->settings.getOption(GB_OPT_SOUND_ENABLED) && this->gameboy->settings.audioBuffer != nullptr) {
+        if(this->synthEnabled) {
             long space = this->gameboy->settings.audioSamples - this->gameboy->audioSamplesWritten;
             long read = this->buffer.samples_avail() / 2;
             if(read > space) {
                 read = space;
             }
 
+            if(this->multiTrack) {
+                this->readChannels(read);
+            }
+
             this->gameboy->audioSamplesWritten += this->buffer.read_samples((s16*) &this->gameboy->settings.audioBuffer[this->gameboy->audioSamplesWritten], read * 2) / 2;
-        } else {
-            this->buffer.clear();
+        }
+
+        // Only switch outputs on a frame boundary, where the Blip buffers hold no pending time.
+        if(this->buffer.center()->sample_rate() != (long) this->gameboy->settings.audioSampleRate) {
+            this->buffer.set_sample_rate((long) this->gameboy->settings.audioSampleRate);
+            this->buffer.clock_rate((long) (CYCLES_PER_SECOND * this->rateScale));
+            this->updateOutputs();
+        } else if(this->isSoundEnabled() != this->synthEnabled) {
+            this->updateOutputs();
+        } else if(this->synthEnabled && this->isMultiTrackEnabled() != this->multiTrack) {
+            // Leave the mix alone, so turning stems on or off doesn't disturb it.
+            this->updateChannelOutputs();
         }
     }
 
@@ -51,11 +76,95 @@ void APU::update() {
 }
 
 u8 APU::read(u16 addr) {
+    this->flushWrites();
+
     return (u8) this->apu.read_register((u32) (this->gameboy->cpu.getCycle() - this->lastSoundCycle) >> this->halfSpeed, addr);
 }
 
 void APU::write(u16 addr, u8 val) {
-    this->apu.write_register((u32) (this->gameboy->cpu.getCycle() - this->lastSoundCycle) >> this->halfSpeed, addr, val);
+    Gb_Apu::write_t& write = this->pendingWrites[this->pendingWriteCount++];
+    write.time = (s32) ((u32) (this->gameboy->cpu.getCycle() - this->lastSoundCycle) >> this->halfSpeed);
+    write.addr = addr;
+    write.data = val;
+
+    if(this->pendingWriteCount == APU_WRITE_QUEUE_SIZE) {
+        this->flushWrites();
+    }
+}
+
+void APU::flushWrites() {
+    if(this->pendingWriteCount > 0) {
+        this->apu.write_registers(this->pendingWrites, (int) this->pendingWriteCount);
+        this->pendingWriteCount = 0;
+    }
+}
+
+bool APU::isSoundEnabled() {
+    return this->gameboy->settings.getOption(GB_OPT_SOUND_ENABLED) && this->gameboy->settings.audioBuffer != nullptr;
+}
+
+bool APU::isMultiTrackEnabled() {
+    for(int i = 0; i < 4; i++) {
+        if(this->gameboy->settings.channelAudioBuffers[i] == nullptr) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void APU::updateOutputs() {
+    this->synthEnabled = this->isSoundEnabled();
+
+    this->buffer.clear();
+
+    if(this->synthEnabled) {
+        this->apu.set_output(this->buffer.center(), this->buffer.left(), this->buffer.right());
+    } else {
+        this->apu.set_output(nullptr);
+    }
+
+    this->updateChannelOutputs();
+}
+
+void APU::updateChannelOutputs() {
+    this->multiTrack = this->synthEnabled && this->isMultiTrackEnabled();
+
+    // Each oscillator also feeds its own buffers, alongside the normal mix rather than instead of it.
+    for(int i = 0; i < 4; i++) {
+        Stereo_Buffer& channel = this->channelBuffers[i];
+
+        if(this->multiTrack) {
+            channel.set_sample_rate((long) this->gameboy->settings.audioSampleRate);
+            channel.clock_rate((long) (CYCLES_PER_SECOND * this->rateScale));
+            channel.clear();
+
+            this->apu.set_stem_output(channel.center(), channel.left(), channel.right(), i);
+        } else {
+            this->apu.set_stem_output(nullptr, nullptr, nullptr, i);
+        }
+    }
+}
+
+void APU::readChannels(long samples) {
+    u32 written = this->gameboy->audioSamplesWritten;
+
+    for(int i = 0; i < 4; i++) {
+        this->channelBuffers[i].read_samples((s16*) &this->gameboy->settings.channelAudioBuffers[i][written], samples * 2);
+    }
+}
+
+void APU::setRateScale(double rateScale) {
+    if(this->rateScale != rateScale) {
+        this->rateScale = rateScale;
+        this->buffer.clock_rate((long) (CYCLES_PER_SECOND * rateScale));
+
+        if(this->multiTrack) {
+            for(int i = 0; i < 4; i++) {
+                this->channelBuffers[i].clock_rate((long) (CYCLES_PER_SECOND * rateScale));
+            }
+        }
+    }
 }
 
 void APU::setHalfSpeed(bool halfSpeed) {
@@ -74,12 +183,15 @@ std::istream& operator>>(std::istream& is, APU& apu) {
     is.read((char*) &apu.lastSoundCycle, sizeof(apu.lastSoundCycle));
     is.read((char*) &apu.halfSpeed, sizeof(apu.halfSpeed));
 
+    apu.pendingWriteCount = 0;
     apu.apu.load_state(apuState);
 
     return is;
 }
 
 std::ostream& operator<<(std::ostream& os, APU& apu) {
+    apu.flushWrites();
+
     gb_apu_state_t apuState;
     apu.apu.save_state(&apuState);
 
@@ -9,63 +9,31 @@
 #include "gameboy.h"
 #include "cartridge.h"
 #include "mmu.h"
+#include "romimage.h"
 
 #define HALF_ROM_BANK_SIZE 0x2000
 
-#define SRAM_BANK_SIZE 0x2000
-#define SRAM_BANK_MASK 0x1FFF
-
 #define HALF_SRAM_BANK_SIZE 0x1000
 #define HALF_SRAM_BANK_MASK 0x0FFF
 
 Cartridge::Cartridge(std::istream& romData, u32 romSize) {
-    this->totalRomBanks = (romSize + ROM_BANK_SIZE - 1) >> 14;
-
-    // Round number of banks to next power of two.
-    if(this->totalRomBanks > 0) {
-        this->totalRomBanks--;
-        this->totalRomBanks |= this->totalRomBanks >> 1;
-        this->totalRomBanks |= this->totalRomBanks >> 2;
-        this->totalRomBanks |= this->totalRomBanks >> 4;
-        this->totalRomBanks |= this->totalRomBanks >> 8;
-        this->totalRomBanks |= this->totalRomBanks >> 16;
-        this->totalRomBanks++;
-    }
-
-    if(this->totalRomBanks < 2) {
-        this->totalRomBanks = 2;
-    }
-
-    size_t roundedSize = (size_t) (this->totalRomBanks * ROM_BANK_SIZE);
-
-    this->rom = new u8[roundedSize]();
-    romData.read((char*) this->rom, romSize);
-
-    // Most MMM01 dumps have the initial banks at the end of the ROM rather than the beginning, so check if this is the case and compensate.
-    if(romSize > 0x8000) {
-        // Check for the logo.
-        static const u8 logo[] = {
-                0xCE, 0xED, 0x66, 0x66, 0xCC, 0x0D, 0x00, 0x0B, 0x03, 0x73, 0x00, 0x83, 0x00, 0x0C, 0x00, 0x0D,
-                0x00, 0x08, 0x11, 0x1F, 0x88, 0x89, 0x00, 0x0E, 0xDC, 0xCC, 0x6E, 0xE6, 0xDD, 0xDD, 0xD9, 0x99,
-                0xBB, 0xBB, 0x67, 0x63, 0x6E, 0x0E, 0xEC ,0xCC, 0xDD, 0xDC, 0x99, 0x9F, 0xBB, 0xB9, 0x33, 0x3E
-        };
-
-        u8* checkBank = &this->rom[roundedSize - 0x8000];
-
-        if(memcmp(logo, &checkBank[0x0104], sizeof(logo)) == 0) {
-            // Check for MMM01.
-            u8 mbcType = checkBank[0x0147];
+    this->image = RomImage::acquire(romData, romSize);
+    this->init();
+}
 
-            if(mbcType >= 0x0B && mbcType <= 0x0D) {
-                u8* copy = new u8[roundedSize];
-                memcpy(copy, this->rom, roundedSize);
+Cartridge::Cartridge(RomImage* image) {
+    this->image = image;
+    this->init();
+}
 
-                memcpy(this->rom, &copy[roundedSize - 0x8000], 0x8000);
-                memcpy(&this->rom[0x8000], copy, roundedSize - 0x8000);
+void Cartridge::init() {
+    this->rom = this->image->getData();
+    this->totalRomBanks = (u16) (this->image->getSize() / ROM_BANK_SIZE);
 
-                delete[] copy;
-            }
-        }
+    this->romBanks.resize(this->totalRomBanks);
+    this->romOverlay.resize(this->totalRomBanks, false);
+    for(u16 bank = 0; bank < this->totalRomBanks; bank++) {
+        this->romBanks[bank] = &this->rom[bank * ROM_BANK_SIZE];
     }
 
     this->romTitle = std::string(reinterpret_cast<char*>(&this->rom[0x0134]), this->rom[0x0143] == 0x80 || this->rom[0x0143] == 0xC0 ? 15 : 16);
@@ -181,7 +149,16 @@ Cartridge::Cartridge(std::istream& romData, u32 romSize) {
     }
 
     this->sram = new u8[this->totalRamBanks * SRAM_BANK_SIZE]();
+    this->sramExternal = false;
     memset(&this->rtcClock, 0, sizeof(this->rtcClock));
+
+    this->sramPages[0] = nullptr;
+    this->sramPages[1] = nullptr;
+    this->sramPageWrite[0] = false;
+    this->sramPageWrite[1] = false;
+    this->sramDirty = 0;
+    this->sramDirtyCycle = 0;
+    this->sramWriteCycle = 0;
 }
 
 Cartridge::~Cartridge() {
@@ -200,13 +177,27 @@ Cartridge::~Cartridge() {
         this->gameboy = nullptr;
     }
 
-    if(this->rom != nullptr) {
-        delete[] this->rom;
-        this->rom = nullptr;
+    for(u16 bank = 0; bank < this->totalRomBanks; bank++) {
+        if(this->romOverlay[bank]) {
+            delete[] this->romBanks[bank];
+        }
+    }
+
+    this->romBanks.clear();
+    this->romOverlay.clear();
+
+    if(this->image != nullptr) {
+        this->image->release();
+        this->image = nullptr;
     }
 
+    this->rom = nullptr;
+
     if(this->sram != nullptr) {
-        delete[] this->sram;
+        if(!this->sramExternal) {
+            delete[] this->sram;
+        }
+
         this->sram = nullptr;
     }
 }
@@ -245,7 +236,12 @@ void Cartridge::reset(Gameboy* gameboy) {
 }
 
 void Cartridge::load(std::istream& data) {
-    data.read((char*) this->sram, this->totalRamBanks * SRAM_BANK_SIZE);
+    if(this->sramExternal) {
+        // SRAM contents are already backed by the save file; only the trailer needs reading.
+        data.seekg(this->totalRamBanks * SRAM_BANK_SIZE);
+    } else {
+        data.read((char*) this->sram, this->totalRamBanks * SRAM_BANK_SIZE);
+    }
 
     if(this->mbcType == MBC3 || this->mbcType == HUC3 || this->mbcType == TAMA5) {
         data.read((char*) &this->rtcClock, sizeof(this->rtcClock));
@@ -253,6 +249,70 @@ void Cartridge::load(std::istream& data) {
 }
 
 void Cartridge::save(std::ostream& data) {
+    if(this->sramExternal) {
+        data.seekp(this->totalRamBanks * SRAM_BANK_SIZE);
+    } else {
+        data.write((char*) this->sram, this->totalRamBanks * SRAM_BANK_SIZE);
+    }
+
+    if(this->mbcType == MBC3 || this->mbcType == HUC3 || this->mbcType == TAMA5) {
+        data.write((char*) &this->rtcClock, sizeof(this->rtcClock));
+    }
+
+    this->sramDirty = 0;
+    if(this->gameboy != nullptr) {
+        // Write-protect the mapped pages again so the next write is tracked.
+        this->mapSramBank();
+    }
+}
+
+u64 Cartridge::getRomHash() {
+    return this->image->getHash();
+}
+
+void Cartridge::saveDirty(std::ostream& data) {
+    // Externally backed SRAM is already in the save file, leaving only the trailer to write.
+    if(!this->sramExternal) {
+        u32 totalPages = (u32) (this->totalRamBanks * SRAM_BANK_SIZE / HALF_SRAM_BANK_SIZE);
+
+        // Write out contiguous runs of dirty pages at their offset in the save.
+        u32 page = 0;
+        while(page < totalPages) {
+            if((this->sramDirty & (1u << page)) == 0) {
+                page++;
+                continue;
+            }
+
+            u32 start = page;
+            while(page < totalPages && (this->sramDirty & (1u << page)) != 0) {
+                page++;
+            }
+
+            data.seekp(start * HALF_SRAM_BANK_SIZE);
+            data.write((char*) &this->sram[start * HALF_SRAM_BANK_SIZE], (page - start) * HALF_SRAM_BANK_SIZE);
+        }
+    }
+
+    if(this->mbcType == MBC3 || this->mbcType == HUC3 || this->mbcType == TAMA5) {
+        data.seekp(this->totalRamBanks * SRAM_BANK_SIZE);
+        data.write((char*) &this->rtcClock, sizeof(this->rtcClock));
+    }
+
+    this->sramDirty = 0;
+    if(this->gameboy != nullptr) {
+        this->mapSramBank();
+    }
+}
+
+void Cartridge::loadBattery(std::istream& data) {
+    data.read((char*) this->sram, this->totalRamBanks * SRAM_BANK_SIZE);
+
+    if(this->mbcType == MBC3 || this->mbcType == HUC3 || this->mbcType == TAMA5) {
+        data.read((char*) &this->rtcClock, sizeof(this->rtcClock));
+    }
+}
+
+void Cartridge::saveBattery(std::ostream& data) {
     data.write((char*) this->sram, this->totalRamBanks * SRAM_BANK_SIZE);
 
     if(this->mbcType == MBC3 || this->mbcType == HUC3 || this->mbcType == TAMA5) {
@@ -260,6 +320,32 @@ void Cartridge::save(std::ostream& data) {
     }
 }
 
+void Cartridge::setSramBuffer(u8* buffer) {
+    if(buffer == this->sram || (buffer == nullptr && !this->sramExternal)) {
+        return;
+    }
+
+    if(buffer == nullptr) {
+        // Detach from the external buffer, keeping its current contents.
+        buffer = new u8[this->totalRamBanks * SRAM_BANK_SIZE];
+        memcpy(buffer, this->sram, this->totalRamBanks * SRAM_BANK_SIZE);
+
+        this->sram = buffer;
+        this->sramExternal = false;
+    } else {
+        if(this->sram != nullptr && !this->sramExternal) {
+            delete[] this->sram;
+        }
+
+        this->sram = buffer;
+        this->sramExternal = true;
+    }
+
+    if(this->gameboy != nullptr) {
+        this->mapSramBank();
+    }
+}
+
 std::istream& operator>>(std::istream& is, Cartridge& cart) {
     is.read((char*) &cart.romBank0, sizeof(cart.romBank0));
     is.read((char*) &cart.romBank1, sizeof(cart.romBank1));
@@ -358,7 +444,10 @@ u8 Cartridge::readSram(u16 addr) {
 void Cartridge::writeSram(u16 addr, u8 val) {
     u8 bank = this->sramBank & (this->totalRamBanks - 1);
     if(bank < this->totalRamBanks) {
-        this->sram[bank * SRAM_BANK_SIZE + (addr & SRAM_BANK_MASK)] = val;
+        u32 offset = bank * SRAM_BANK_SIZE + (addr & SRAM_BANK_MASK);
+
+        this->sram[offset] = val;
+        this->markSramDirty(offset);
     } else {
         if(this->gameboy->settings.printDebug != nullptr) {
             this->gameboy->settings.printDebug("Attempted to write to invalid SRAM bank: %" PRIu8 "\n", bank);
@@ -366,12 +455,77 @@ void Cartridge::writeSram(u16 addr, u8 val) {
     }
 }
 
+u8* Cartridge::patchRomBank(u16 bank) {
+    if(bank >= this->totalRomBanks) {
+        return nullptr;
+    }
+
+    if(!this->romOverlay[bank]) {
+        // Give this cartridge its own copy of the bank, leaving the shared image untouched.
+        u8* copy = new u8[ROM_BANK_SIZE];
+        memcpy(copy, this->romBanks[bank], ROM_BANK_SIZE);
+
+        this->romBanks[bank] = copy;
+        this->romOverlay[bank] = true;
+
+        if(this->gameboy != nullptr) {
+            this->mapBanks();
+        }
+    }
+
+    return this->romBanks[bank];
+}
+
+void Cartridge::unpatchRomBank(u16 bank) {
+    if(bank >= this->totalRomBanks || !this->romOverlay[bank]) {
+        return;
+    }
+
+    // Drop the copy once every patch in it has been reverted.
+    u8* original = &this->rom[bank * ROM_BANK_SIZE];
+    if(memcmp(this->romBanks[bank], original, ROM_BANK_SIZE) == 0) {
+        delete[] this->romBanks[bank];
+
+        this->romBanks[bank] = original;
+        this->romOverlay[bank] = false;
+
+        if(this->gameboy != nullptr) {
+            this->mapBanks();
+        }
+    }
+}
+
+void Cartridge::writeSramPage(u16 addr, u8 val) {
+    u8 index = (u8) ((addr >> 12) & 1);
+
+    u8* block = this->sramPages[index];
+    if(block == nullptr || !this->sramPageWrite[index]) {
+        return;
+    }
+
+    block[addr & HALF_SRAM_BANK_MASK] = val;
+    this->markSramDirty((u32) (block - this->sram));
+
+    // The page is dirty now; let further writes go straight through the MMU until the next flush.
+    this->gameboy->mmu.mapPage((u8) (addr >> 12), block, this->readFunc == nullptr, true);
+}
+
+void Cartridge::markSramDirty(u32 offset) {
+    u64 cycle = this->gameboy->cpu.getCycle();
+    if(this->sramDirty == 0) {
+        this->sramDirtyCycle = cycle;
+    }
+
+    this->sramDirty |= 1u << (offset / HALF_SRAM_BANK_SIZE);
+    this->sramWriteCycle = cycle;
+}
+
 void Cartridge::mapRomBank0() {
     bool override = this->gameboy->mmu.isBiosMapped();
 
     u16 bank = this->romBank0 & (this->totalRomBanks - 1);
     if(!override && bank < this->totalRomBanks) {
-        u8* bankPtr = &this->rom[bank * ROM_BANK_SIZE];
+        u8* bankPtr = this->romBanks[bank];
 
         this->gameboy->mmu.mapPage(0x0, bankPtr + 0x0000, true, false);
         this->gameboy->mmu.mapPage(0x1, bankPtr + 0x1000, true, false);
@@ -395,7 +549,7 @@ void Cartridge::mapRomBank1() {
 
         u8 bank1A = this->mbc6.romBank1A & (totalHalfBanks - 1);
         if(bank1A < totalHalfBanks) {
-            u8* bankPtr = &this->rom[bank1A * HALF_ROM_BANK_SIZE];
+            u8* bankPtr = this->romBanks[bank1A >> 1] + (bank1A & 1) * HALF_ROM_BANK_SIZE;
 
             this->gameboy->mmu.mapPage(0x4, bankPtr + 0x0000, true, false);
             this->gameboy->mmu.mapPage(0x5, bankPtr + 0x1000, true, false);
@@ -410,7 +564,7 @@ void Cartridge::mapRomBank1() {
 
         u8 bank1B = this->mbc6.romBank1B & (totalHalfBanks - 1);
         if(bank1B < totalHalfBanks) {
-            u8* bankPtr = &this->rom[bank1B * HALF_ROM_BANK_SIZE];
+            u8* bankPtr = this->romBanks[bank1B >> 1] + (bank1B & 1) * HALF_ROM_BANK_SIZE;
 
             this->gameboy->mmu.mapPage(0x6, bankPtr + 0x0000, true, false);
             this->gameboy->mmu.mapPage(0x7, bankPtr + 0x1000, true, false);
@@ -425,7 +579,7 @@ void Cartridge::mapRomBank1() {
     } else {
         u16 bank = this->romBank1 & (this->totalRomBanks - 1);
         if(bank < this->totalRomBanks) {
-            u8* bankPtr = &this->rom[bank * ROM_BANK_SIZE];
+            u8* bankPtr = this->romBanks[bank];
 
             this->gameboy->mmu.mapPage(0x4, bankPtr + 0x0000, true, false);
             this->gameboy->mmu.mapPage(0x5, bankPtr + 0x1000, true, false);
@@ -444,6 +598,15 @@ void Cartridge::mapRomBank1() {
     }
 }
 
+void Cartridge::mapSramPage(u8 page, u8* block, bool read, bool write) {
+    this->sramPages[page & 1] = block;
+    this->sramPageWrite[page & 1] = write;
+
+    // Clean pages are mapped read-only so that the first write lands in writeSramPage and gets recorded.
+    bool dirty = block != nullptr && (this->sramDirty & (1u << ((block - this->sram) / HALF_SRAM_BANK_SIZE))) != 0;
+    this->gameboy->mmu.mapPage(page, block, read, write && dirty);
+}
+
 void Cartridge::mapSramBank() {
     if(this->sramEnabled && this->totalRamBanks > 0) {
         bool read = this->readFunc == nullptr;
@@ -456,47 +619,47 @@ void Cartridge::mapSramBank() {
             if(bankA < totalHalfBanks) {
                 u8* bankPtr = &this->sram[bankA * HALF_SRAM_BANK_SIZE];
 
-                this->gameboy->mmu.mapPage(0xA, bankPtr, read, write);
+                this->mapSramPage(0xA, bankPtr, read, write);
             } else {
                 if(this->gameboy->settings.printDebug != nullptr) {
                     this->gameboy->settings.printDebug("Attempted to access invalid SRAM half-bank: %" PRIu8 "\n", bankA);
                 }
 
-                this->gameboy->mmu.mapPage(0xA, nullptr, false, false);
+                this->mapSramPage(0xA, nullptr, false, false);
             }
 
             u8 bankB = this->mbc6.sramBankB & (totalHalfBanks - 1);
             if(bankB < totalHalfBanks) {
                 u8* bankPtr = &this->sram[bankB * HALF_SRAM_BANK_SIZE];
 
-                this->gameboy->mmu.mapPage(0xB, bankPtr, read, write);
+                this->mapSramPage(0xB, bankPtr, read, write);
             } else {
                 if(this->gameboy->settings.printDebug != nullptr) {
                     this->gameboy->settings.printDebug("Attempted to access invalid SRAM half-bank: %" PRIu8 "\n", bankB);
                 }
 
-                this->gameboy->mmu.mapPage(0xB, nullptr, false, false);
+                this->mapSramPage(0xB, nullptr, false, false);
             }
         } else {
             u8 bank = this->sramBank & (this->totalRamBanks - 1);
             if(bank < this->totalRamBanks) {
                 u8* bankPtr = &this->sram[bank * SRAM_BANK_SIZE];
 
-                this->gameboy->mmu.mapPage(0xA, bankPtr + 0x0000, read, write);
-                this->gameboy->mmu.mapPage(0xB, bankPtr + 0x1000, read, write);
+                this->mapSramPage(0xA, bankPtr + 0x0000, read, write);
+                this->mapSramPage(0xB, bankPtr + 0x1000, read, write);
             } else {
                 // Only report if there's no chance it's a special bank number.
                 if(this->readFunc == nullptr && this->gameboy->settings.printDebug != nullptr) {
                     this->gameboy->settings.printDebug("Attempted to access invalid SRAM bank: %" PRIu8 "\n", bank);
                 }
 
-                this->gameboy->mmu.mapPage(0xA, nullptr, false, false);
-                this->gameboy->mmu.mapPage(0xB, nullptr, false, false);
+                this->mapSramPage(0xA, nullptr, false, false);
+                this->mapSramPage(0xB, nullptr, false, false);
             }
         }
     } else {
-        this->gameboy->mmu.mapPage(0xA, nullptr, false, false);
-        this->gameboy->mmu.mapPage(0xB, nullptr, false, false);
+        this->mapSramPage(0xA, nullptr, false, false);
+        this->mapSramPage(0xB, nullptr, false, false);
     }
 }
 
@@ -1372,7 +1535,36 @@ void Cartridge::camu() {
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #define CLAMP(min, v, max) MIN(MAX((v), (min)), (max))
 
-static const float edgeRatioLUT[8] = {0.50, 0.75, 1.00, 1.25, 2.00, 3.00, 4.00, 5.00};
+// Edge enhancement ratios (0.50, 0.75, 1.00, 1.25, 2.00, 3.00, 4.00, 5.00), in quarters.
+static const s32 edgeRatioLUT[8] = {2, 3, 4, 5, 8, 12, 16, 20};
+
+// Sensor lines carry one pixel of padding on either side, repeating the edge pixel, so that
+// the filters below can read horizontal neighbours without bounds checks. The loops are kept
+// branch-free over 16-bit values so that the compiler can vectorise them.
+#define CAMERA_LINE_PITCH (CAMERA_SENSOR_WIDTH + 2)
+
+static inline s16* camLine(s16* buffer, int y) {
+    return &buffer[CLAMP(0, y, CAMERA_SENSOR_HEIGHT - 1) * CAMERA_LINE_PITCH + 1];
+}
+
+static inline void camPadLine(s16* line) {
+    line[-1] = line[0];
+    line[CAMERA_SENSOR_WIDTH] = line[CAMERA_SENSOR_WIDTH - 1];
+}
+
+// Adds or subtracts each pixel and the one below it, as selected by the P and M registers.
+static void camFilterVertical(s16* dst, s16* src, s32 currWeight, s32 southWeight) {
+    for(int y = 0; y < CAMERA_SENSOR_HEIGHT; y++) {
+        s16* line = camLine(src, y);
+        s16* lineS = camLine(src, y + 1);
+        s16* out = camLine(dst, y);
+
+        for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
+            s32 value = line[x] * currWeight + lineS[x] * southWeight;
+            out[x] = (s16) CLAMP(-128, value, 127);
+        }
+    }
+}
 
 void Cartridge::camTakePicture() {
     u32 pBits = (u32) (((this->camera.regs[0] >> 1) & 3) != 0);
@@ -1381,7 +1573,7 @@ void Cartridge::camTakePicture() {
     u32 vhBits = (u32) ((this->camera.regs[1] & 0x60) >> 5);
     u32 exposureBits = this->camera.regs[3] | (this->camera.regs[2] << 8);
     u32 iBit = (u32) ((this->camera.regs[4] & 0x08) >> 3);
-    float edgeAlpha = edgeRatioLUT[(this->camera.regs[4] & 0x70) >> 4];
+    s32 edgeAlpha = edgeRatioLUT[(this->camera.regs[4] & 0x70) >> 4];
     u32 e3Bit = (u32) ((this->camera.regs[4] & 0x80) >> 7);
 
     this->camera.readyCycle = this->gameboy->cpu.getCycle() + exposureBits * 64 + (nBit ? 0 : 2048) + 129784;
@@ -1396,85 +1588,66 @@ void Cartridge::camTakePicture() {
         return;
     }
 
-    int filtered[CAMERA_SENSOR_WIDTH * CAMERA_SENSOR_HEIGHT];
+    s16 filtered[CAMERA_SENSOR_HEIGHT * CAMERA_LINE_PITCH];
+    s16 tempBuf[CAMERA_SENSOR_HEIGHT * CAMERA_LINE_PITCH];
 
+    s32 exposure = (s32) exposureBits;
+    s32 invertMask = iBit ? 0xFF : 0x00;
     for(int y = 0; y < CAMERA_SENSOR_HEIGHT; y++) {
         u32* line = &image[y * CAMERA_SENSOR_WIDTH];
-        for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
-            int val = (int) CLAMP(0, ((((((2 * (line[x] & 0xFF) + 5 * ((line[x] >> 8) & 0xFF) + 1 * ((line[x] >> 16) & 0xFF)) >> 3) * exposureBits) / CAMERA_EXPOSURE_REFERENCE) - 128) / 8) + 128, 255);
-            if(iBit) {
-                val = 255 - val;
-            }
+        s16* out = camLine(filtered, y);
 
-            filtered[y * CAMERA_SENSOR_WIDTH + x] = val - 128;
+        for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
+            s32 luma = (s32) ((2 * (line[x] & 0xFF) + 5 * ((line[x] >> 8) & 0xFF) + 1 * ((line[x] >> 16) & 0xFF)) >> 3);
+            s32 value = ((((luma * exposure) / CAMERA_EXPOSURE_REFERENCE) - 128) / 8) + 128;
+            out[x] = (s16) ((CLAMP(0, value, 255) ^ invertMask) - 128);
         }
+
+        camPadLine(out);
     }
 
-    int tempBuf[CAMERA_SENSOR_WIDTH * CAMERA_SENSOR_HEIGHT];
+    // Weight of the current and next line in the vertical pass.
+    s32 currWeight = (s32) (pBits & 0x1) - (s32) (mBits & 0x1);
+    s32 southWeight = (s32) ((pBits >> 1) & 0x1) - (s32) ((mBits >> 1) & 0x1);
+
+    s16* result = filtered;
 
     u32 filterMode = (nBit << 3) | (vhBits << 1) | e3Bit;
     switch(filterMode) {
         case 0x0:
-            memcpy(tempBuf, filtered, sizeof(tempBuf));
-
-            for(int y = 0; y < CAMERA_SENSOR_HEIGHT; y++) {
-                int* line = &filtered[y * CAMERA_SENSOR_WIDTH];
-                int* tempLine = &tempBuf[y * CAMERA_SENSOR_WIDTH];
-                int* tempLineS = &tempBuf[MIN(y + 1, CAMERA_SENSOR_HEIGHT - 1) * CAMERA_SENSOR_WIDTH];
-
-                for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
-                    int value = 0;
-                    if(pBits & 0x1) value += tempLine[x];
-                    if(pBits & 0x2) value += tempLineS[x];
-                    if(mBits & 0x1) value -= tempLine[x];
-                    if(mBits & 0x2) value -= tempLineS[x];
-                    line[x] = CLAMP(-128, value, 127);
-                }
-            }
-
+            camFilterVertical(tempBuf, filtered, currWeight, southWeight);
+            result = tempBuf;
             break;
         case 0x1:
             memset(filtered, 0, sizeof(filtered));
             break;
         case 0x2:
             for(int y = 0; y < CAMERA_SENSOR_HEIGHT; y++) {
-                int* line = &filtered[y * CAMERA_SENSOR_WIDTH];
-                int* tempLine = &tempBuf[y * CAMERA_SENSOR_WIDTH];
+                s16* line = camLine(filtered, y);
+                s16* tempLine = camLine(tempBuf, y);
 
                 for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
-                    tempLine[x] = CLAMP(0, (int) (line[x] + ((2 * line[x] - line[MAX(0, x - 1)] - line[MIN(x + 1, CAMERA_SENSOR_WIDTH - 1)]) * edgeAlpha)), 255);
-                }
-            }
-
-            for(int y = 0; y < CAMERA_SENSOR_HEIGHT; y++) {
-                int* line = &filtered[y * CAMERA_SENSOR_WIDTH];
-                int* tempLine = &tempBuf[y * CAMERA_SENSOR_WIDTH];
-                int* tempLineS = &tempBuf[MIN(y + 1, CAMERA_SENSOR_HEIGHT - 1) * CAMERA_SENSOR_WIDTH];
-
-                for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
-                    int value = 0;
-                    if(pBits & 0x1) value += tempLine[x];
-                    if(pBits & 0x2) value += tempLineS[x];
-                    if(mBits & 0x1) value -= tempLine[x];
-                    if(mBits & 0x2) value -= tempLineS[x];
-                    line[x] = CLAMP(-128, value, 127);
+                    s32 edge = 2 * line[x] - line[x - 1] - line[x + 1];
+                    tempLine[x] = (s16) CLAMP(0, (4 * line[x] + edge * edgeAlpha) / 4, 255);
                 }
             }
 
+            camFilterVertical(filtered, tempBuf, currWeight, southWeight);
             break;
         case 0xE:
             for(int y = 0; y < CAMERA_SENSOR_HEIGHT; y++) {
-                int* line = &filtered[y * CAMERA_SENSOR_WIDTH];
-                int* lineS = &filtered[MIN(y + 1, CAMERA_SENSOR_HEIGHT - 1) * CAMERA_SENSOR_WIDTH];
-                int* lineN = &filtered[MAX(0, y - 1) * CAMERA_SENSOR_WIDTH];
-                int* tempLine = &tempBuf[y * CAMERA_SENSOR_WIDTH];
+                s16* line = camLine(filtered, y);
+                s16* lineS = camLine(filtered, y + 1);
+                s16* lineN = camLine(filtered, y - 1);
+                s16* tempLine = camLine(tempBuf, y);
 
                 for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
-                    tempLine[x] = CLAMP(-128, (int) (line[x] + ((4 * line[x] - line[MAX(0, x - 1)] - line[MIN(x + 1, CAMERA_SENSOR_WIDTH - 1)] - lineN[x] - lineS[x]) * edgeAlpha)), 127);
+                    s32 edge = 4 * line[x] - line[x - 1] - line[x + 1] - lineN[x] - lineS[x];
+                    tempLine[x] = (s16) CLAMP(-128, (4 * line[x] + edge * edgeAlpha) / 4, 127);
                 }
             }
 
-            memcpy(filtered, tempBuf, sizeof(filtered));
+            result = tempBuf;
             break;
         default:
             if(this->gameboy->settings.printDebug != nullptr) {
@@ -1484,41 +1657,46 @@ void Cartridge::camTakePicture() {
             break;
     }
 
-    int processed[CAMERA_PROCESSED_WIDTH * CAMERA_PROCESSED_HEIGHT];
-
-    for(int y = 0; y < CAMERA_SENSOR_HEIGHT; y++) {
-        int* line = &filtered[(y + (CAMERA_SENSOR_EXTRA_LINES / 2)) * CAMERA_SENSOR_WIDTH];
-        int* processedLine = &processed[y * CAMERA_SENSOR_WIDTH];
-
-        for(int x = 0; x < CAMERA_SENSOR_WIDTH; x++) {
-            int base = 6 + ((y & 3) * 4 + (x & 3)) * 3;
-            u32 value = (u32) (line[x] + 128);
-            if(value < this->camera.regs[base + 0]) {
-                processedLine[x] = 0x00;
-            } else if(value < this->camera.regs[base + 1]) {
-                processedLine[x] = 0x40;
-            } else if(value < this->camera.regs[base + 2]) {
-                processedLine[x] = 0x80;
-            } else {
-                processedLine[x] = 0xC0;
-            }
+    // Expand the 4x4 dither matrix to whole lines of thresholds up front.
+    u8 thresholds[4][3][CAMERA_PROCESSED_WIDTH];
+    for(int row = 0; row < 4; row++) {
+        for(int x = 0; x < CAMERA_PROCESSED_WIDTH; x++) {
+            u8* entry = &this->camera.regs[6 + (row * 4 + (x & 3)) * 3];
+            thresholds[row][0][x] = entry[0];
+            thresholds[row][1][x] = entry[1];
+            thresholds[row][2][x] = entry[2];
         }
     }
 
     for(int y = 0; y < CAMERA_PROCESSED_HEIGHT; y++) {
-        int* line = &processed[y * CAMERA_PROCESSED_WIDTH];
+        s16* line = camLine(result, y + (CAMERA_SENSOR_EXTRA_LINES / 2));
+        u8* low = thresholds[y & 3][0];
+        u8* mid = thresholds[y & 3][1];
+        u8* high = thresholds[y & 3][2];
 
+        u8 colors[CAMERA_PROCESSED_WIDTH];
         for(int x = 0; x < CAMERA_PROCESSED_WIDTH; x++) {
-            u8 color = (u8) (3 - (line[x] >> 6));
-            u16 addr = (u16) (0x0100 + ((y >> 3) * 16 + (x >> 3)) * 16 + ((y & 7) * 2));
+            s32 value = line[x] + 128;
+            s32 level = (value >= low[x]) * (1 + (value >= mid[x]) * (1 + (value >= high[x])));
+            colors[x] = (u8) (3 - level);
+        }
 
-            if(color & 1) {
-                this->writeSram(addr, (u8) (1 << (7 - (7 & x))));
-            }
+        // Pack each 8 pixel tile row into its two bitplanes.
+        u16 addr = (u16) (0x0100 + (y >> 3) * 16 * 16 + (y & 7) * 2);
+        for(int tileX = 0; tileX < CAMERA_PROCESSED_WIDTH / 8; tileX++) {
+            u8* tileColors = &colors[tileX * 8];
 
-            if(color & 2) {
-                this->writeSram((u16) (addr + 1), (u8) (1 << (7 - (7 & x))));
+            u8 plane0 = 0;
+            u8 plane1 = 0;
+            for(int x = 0; x < 8; x++) {
+                plane0 |= (tileColors[x] & 1) << (7 - x);
+                plane1 |= ((tileColors[x] >> 1) & 1) << (7 - x);
             }
+
+            this->writeSram(addr, plane0);
+            this->writeSram((u16) (addr + 1), plane1);
+
+            addr += 16;
         }
     }
 }
@@ -1545,7 +1723,11 @@ static u32 daysInLeapMonth[12] = {
 
 void Cartridge::latchClock() {
     time_t now;
-    time(&now);
+    if(this->gameboy->settings.getTime != nullptr) {
+        now = (time_t) this->gameboy->settings.getTime();
+    } else {
+        time(&now);
+    }
 
     time_t difference = (time_t) (now - this->rtcClock.last);
     struct tm* lt = gmtime((const time_t*) &difference);
@@ -8,30 +8,71 @@
 
 #define TO_INT(a) ( (a) >= 'a' ? (a) - 'a' + 10 : (a) >= 'A' ? (a) - 'A' + 10 : (a) - '0')
 
-void CheatEngine::update() {
+void CheatEngine::compilePatches() {
+    this->patches.clear();
+
     for(const Cheat& cheat : this->cheats) {
         if(cheat.enabled) {
             for(const CheatLine& line : cheat.lines) {
                 if(line.type == CHEAT_TYPE_GAMESHARK) {
-                    u8 oldSvbk = this->gameboy->mmu.read(SVBK);
+                    CheatPatch patch;
+                    patch.address = line.address;
+                    patch.data = line.data;
+
                     switch(line.bank & 0xF0) {
                         case 0x00:
-                            this->gameboy->mmu.write(line.address, line.data);
+                            patch.dst = this->gameboy->mmu.getWritePointer(line.address);
                             break;
                         case 0x80: /* TODO : Find info and stuff */
-                            break;
+                            continue;
                         case 0x90:
-                            this->gameboy->mmu.write(SVBK, (u8) (line.bank & 7));
-                            this->gameboy->mmu.write(line.address, line.data);
-                            this->gameboy->mmu.write(SVBK, oldSvbk);
+                            // Only a CGB can switch WRAM banks; otherwise this is a plain write.
+                            if(this->gameboy->gbMode == MODE_CGB && line.address >= 0xD000 && line.address < 0xE000) {
+                                u8 wramBank = (u8) (line.bank & 7);
+                                patch.dst = &this->gameboy->mmu.getWramBank(wramBank != 0 ? wramBank : (u8) 1)[line.address & 0xFFF];
+                            } else {
+                                patch.dst = this->gameboy->mmu.getWritePointer(line.address);
+                            }
+
                             break;
                         default:
-                            break;
+                            continue;
                     }
+
+                    this->patches.push_back(patch);
                 }
             }
         }
     }
+
+    this->patchesDirty = false;
+    this->patchGeneration = this->gameboy->mmu.getMapGeneration();
+}
+
+void CheatEngine::update() {
+    if(this->romPatchesDirty) {
+        this->applyRomPatches();
+    }
+
+    if(this->patchesDirty || this->patchGeneration != this->gameboy->mmu.getMapGeneration()) {
+        this->compilePatches();
+    }
+
+    u32 numPatches = this->patches.size();
+    for(u32 i = 0; i < numPatches; i++) {
+        const CheatPatch& patch = this->patches[i];
+        if(patch.dst != nullptr) {
+            *patch.dst = patch.data;
+        } else {
+            this->gameboy->mmu.write(patch.address, patch.data);
+
+            // The write may have switched banks, leaving the rest of the list stale.
+            // Recompiling keeps the same order, so carry on from the same index.
+            if(this->patchGeneration != this->gameboy->mmu.getMapGeneration()) {
+                this->compilePatches();
+            }
+        }
+    }
 }
 
 void CheatEngine::clearCheats() {
@@ -41,6 +82,12 @@ void CheatEngine::clearCheats() {
     }
 
     this->cheats.clear();
+    this->patchesDirty = true;
+
+    // Revert ROM patches straight away rather than before the next frame, as there may not be one.
+    if(this->romPatchesDirty) {
+        this->applyRomPatches();
+    }
 }
 
 void CheatEngine::parseLine(Cheat& cheat, const std::string& line) {
@@ -49,8 +96,6 @@ void CheatEngine::parseLine(Cheat& cheat, const std::string& line) {
 
         // Clear all flags
         cheatLine.type = CHEAT_TYPE_UNKNOWN;
-        cheatLine.patchedBanks.clear();
-        cheatLine.patchedValues.clear();
 
         std::string::size_type len = line.length();
 
@@ -126,41 +171,97 @@ void CheatEngine::toggleCheat(u32 cheat, bool enabled) {
     Cheat& c = this->cheats[cheat];
     c.enabled = enabled;
 
-    if(this->gameboy->cartridge != nullptr) {
-        if(enabled) {
-            for(u16 bank = 0; bank < this->gameboy->cartridge->getRomBanks(); bank++) {
-                u8* bankPtr = this->gameboy->cartridge->getRomBank(bank);
-                if(bankPtr != nullptr) {
-                    for(CheatLine &line : c.lines) {
-                        if(line.type == CHEAT_TYPE_GAMEGENIE_SHORT || line.type == CHEAT_TYPE_GAMEGENIE_LONG) {
-                            u16 bankSlot = line.address / ROM_BANK_SIZE;
-                            if((bankSlot == 0 && bank == 0) || (bankSlot == 1 && bank != 0)) {
-                                u16 address = line.address & ROM_BANK_MASK;
-                                if((line.type == CHEAT_TYPE_GAMEGENIE_SHORT || bankPtr[address] == line.compare)
-                                   && std::find(line.patchedBanks.begin(), line.patchedBanks.end(), bank) == line.patchedBanks.end()) {
-                                    line.patchedBanks.push_back(bank);
-                                    line.patchedValues.push_back(bankPtr[address]);
-                                    bankPtr[address] = line.data;
-                                }
-                            }
-                        }
-                    }
+    this->patchesDirty = true;
+
+    // ROM patches are applied in one pass before the next frame, so that enabling a whole
+    // cheat file at load doesn't scan the ROM once per code.
+    for(const CheatLine& line : c.lines) {
+        if(line.type == CHEAT_TYPE_GAMEGENIE_SHORT || line.type == CHEAT_TYPE_GAMEGENIE_LONG) {
+            this->romPatchesDirty = true;
+            break;
+        }
+    }
+}
+
+void CheatEngine::applyRomPatches() {
+    Cartridge* cart = this->gameboy->cartridge;
+
+    // Put back everything from the last pass, newest first so that codes patching the same byte unwind correctly.
+    std::vector<RomUndo> previous;
+    previous.swap(this->romUndo);
+
+    if(cart == nullptr || cart != this->romPatchedCartridge) {
+        previous.clear();
+    }
+
+    for(auto it = previous.rbegin(); it != previous.rend(); it++) {
+        cart->getRomBank(it->bank)[it->offset] = it->value;
+    }
+
+    this->romPatchedCartridge = cart;
+    this->romPatchesDirty = false;
+
+    if(cart == nullptr) {
+        return;
+    }
+
+    // Codes for 0x0000-0x3FFF only apply to bank 0, and codes for 0x4000-0x7FFF to every other bank.
+    std::vector<RomPatch> slots[2];
+    for(const Cheat& cheat : this->cheats) {
+        if(cheat.enabled) {
+            for(const CheatLine& line : cheat.lines) {
+                if((line.type == CHEAT_TYPE_GAMEGENIE_SHORT || line.type == CHEAT_TYPE_GAMEGENIE_LONG) && line.address < ROM_BANK_SIZE * 2) {
+                    RomPatch patch;
+                    patch.offset = (u16) (line.address & ROM_BANK_MASK);
+                    patch.data = line.data;
+                    patch.compare = line.compare;
+                    patch.hasCompare = line.type == CHEAT_TYPE_GAMEGENIE_LONG;
+
+                    slots[line.address / ROM_BANK_SIZE].push_back(patch);
                 }
             }
-        } else {
-            for(CheatLine &line : c.lines) {
-                if(line.type == CHEAT_TYPE_GAMEGENIE_SHORT || line.type == CHEAT_TYPE_GAMEGENIE_LONG) {
-                    for(u32 i = 0; i < line.patchedBanks.size(); i++) {
-                        u8* bank = this->gameboy->cartridge->getRomBank(line.patchedBanks[i]);
-                        if(bank != nullptr) {
-                            bank[line.address & ROM_BANK_MASK] = line.patchedValues[i];
-                        }
-                    }
+        }
+    }
+
+    // Walk each bank in address order; the sort is stable, so codes for the same byte still apply in cheat order.
+    for(std::vector<RomPatch>& slot : slots) {
+        std::stable_sort(slot.begin(), slot.end(), [](const RomPatch& a, const RomPatch& b) {
+            return a.offset < b.offset;
+        });
+    }
+
+    u16 banks = cart->getRomBanks();
+    for(u16 bank = 0; bank < banks; bank++) {
+        const std::vector<RomPatch>& slot = slots[bank == 0 ? 0 : 1];
+        if(slot.empty()) {
+            continue;
+        }
 
-                    line.patchedBanks.clear();
-                    line.patchedValues.clear();
+        u8* bankPtr = cart->getRomBank(bank);
+        bool copied = false;
+
+        for(const RomPatch& patch : slot) {
+            if(!patch.hasCompare || bankPtr[patch.offset] == patch.compare) {
+                if(!copied) {
+                    bankPtr = cart->patchRomBank(bank);
+                    copied = true;
                 }
+
+                RomUndo undo;
+                undo.bank = bank;
+                undo.offset = patch.offset;
+                undo.value = bankPtr[patch.offset];
+                this->romUndo.push_back(undo);
+
+                bankPtr[patch.offset] = patch.data;
             }
         }
     }
-}
\ No newline at end of file
+
+    // Drop the copies of banks that no longer hold any patches. Both logs are in bank order.
+    for(u32 i = 0; i < previous.size(); i++) {
+        if(i == 0 || previous[i].bank != previous[i - 1].bank) {
+            cart->unpatchRomBank(previous[i].bank);
+        }
+    }
+}
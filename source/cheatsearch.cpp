@@ -0,0 +1,339 @@
+#include <cstdio>
+#include <cstring>
+
+#include "cartridge.h"
+#include "cheatsearch.h"
+#include "gameboy.h"
+#include "mmu.h"
+#include "simd.h"
+
+#define SEARCH_BLOCK_SIZE 16
+
+#define GAMESHARK_BANK_DEFAULT 0x01
+#define GAMESHARK_BANK_WRAM 0x90
+
+#define HRAM_START 0xFF80
+#define HRAM_SIZE 0x7F
+
+static u32 cheatSearchPopCount(u16 bits) {
+    u32 count = 0;
+    while(bits != 0) {
+        bits &= bits - 1;
+        count++;
+    }
+
+    return count;
+}
+
+// Returns a bit per byte of the block, set where the byte passes the relation.
+#if SIMD_SSE2
+
+static u16 cheatSearchMatch(SearchRelation relation, const u8* prev, const u8* cur, u8 value) {
+    __m128i p = _mm_loadu_si128((const __m128i*) prev);
+    __m128i c = _mm_loadu_si128((const __m128i*) cur);
+    __m128i v = _mm_set1_epi8((char) value);
+
+    switch(relation) {
+        case SEARCH_EQUAL_TO:
+            return (u16) _mm_movemask_epi8(_mm_cmpeq_epi8(c, v));
+        case SEARCH_NOT_EQUAL_TO:
+            return (u16) ~_mm_movemask_epi8(_mm_cmpeq_epi8(c, v));
+        case SEARCH_CHANGED:
+            return (u16) ~_mm_movemask_epi8(_mm_cmpeq_epi8(c, p));
+        case SEARCH_UNCHANGED:
+            return (u16) _mm_movemask_epi8(_mm_cmpeq_epi8(c, p));
+        case SEARCH_INCREASED:
+            // SSE2 only has unsigned min/max, so greater is "max is cur, and they differ".
+            return (u16) (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(c, p), c)) & ~_mm_movemask_epi8(_mm_cmpeq_epi8(c, p)));
+        case SEARCH_DECREASED:
+            return (u16) (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(c, p), c)) & ~_mm_movemask_epi8(_mm_cmpeq_epi8(c, p)));
+        case SEARCH_INCREASED_BY:
+            return (u16) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_sub_epi8(c, p), v));
+        case SEARCH_DECREASED_BY:
+            return (u16) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_sub_epi8(p, c), v));
+        default:
+            return 0;
+    }
+}
+
+#elif SIMD_NEON
+
+static u16 cheatSearchMoveMask(uint8x16_t match) {
+    static const u8 weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+
+    // Sum the weighted lanes of each half down to one byte each.
+    uint8x16_t masked = vandq_u8(match, vld1q_u8(weights));
+    uint8x8_t sums = vpadd_u8(vget_low_u8(masked), vget_high_u8(masked));
+    sums = vpadd_u8(sums, sums);
+    sums = vpadd_u8(sums, sums);
+
+    return vget_lane_u16(vreinterpret_u16_u8(sums), 0);
+}
+
+static u16 cheatSearchMatch(SearchRelation relation, const u8* prev, const u8* cur, u8 value) {
+    uint8x16_t p = vld1q_u8(prev);
+    uint8x16_t c = vld1q_u8(cur);
+    uint8x16_t v = vdupq_n_u8(value);
+
+    switch(relation) {
+        case SEARCH_EQUAL_TO:
+            return cheatSearchMoveMask(vceqq_u8(c, v));
+        case SEARCH_NOT_EQUAL_TO:
+            return (u16) ~cheatSearchMoveMask(vceqq_u8(c, v));
+        case SEARCH_CHANGED:
+            return (u16) ~cheatSearchMoveMask(vceqq_u8(c, p));
+        case SEARCH_UNCHANGED:
+            return cheatSearchMoveMask(vceqq_u8(c, p));
+        case SEARCH_INCREASED:
+            return cheatSearchMoveMask(vcgtq_u8(c, p));
+        case SEARCH_DECREASED:
+            return cheatSearchMoveMask(vcltq_u8(c, p));
+        case SEARCH_INCREASED_BY:
+            return cheatSearchMoveMask(vceqq_u8(vsubq_u8(c, p), v));
+        case SEARCH_DECREASED_BY:
+            return cheatSearchMoveMask(vceqq_u8(vsubq_u8(p, c), v));
+        default:
+            return 0;
+    }
+}
+
+#else
+
+static u16 cheatSearchMatch(SearchRelation relation, const u8* prev, const u8* cur, u8 value) {
+    u16 mask = 0;
+    for(u32 i = 0; i < SEARCH_BLOCK_SIZE; i++) {
+        bool match = false;
+        switch(relation) {
+            case SEARCH_EQUAL_TO:
+                match = cur[i] == value;
+                break;
+            case SEARCH_NOT_EQUAL_TO:
+                match = cur[i] != value;
+                break;
+            case SEARCH_CHANGED:
+                match = cur[i] != prev[i];
+                break;
+            case SEARCH_UNCHANGED:
+                match = cur[i] == prev[i];
+                break;
+            case SEARCH_INCREASED:
+                match = cur[i] > prev[i];
+                break;
+            case SEARCH_DECREASED:
+                match = cur[i] < prev[i];
+                break;
+            case SEARCH_INCREASED_BY:
+                match = (u8) (cur[i] - prev[i]) == value;
+                break;
+            case SEARCH_DECREASED_BY:
+                match = (u8) (prev[i] - cur[i]) == value;
+                break;
+            default:
+                break;
+        }
+
+        if(match) {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+}
+
+#endif
+
+void CheatSearch::addRegion(SearchRegionType type, u8 index, u32 size, u16 address, u8 bank) {
+    SearchRegion region;
+    region.type = type;
+    region.index = index;
+    region.offset = this->regions.empty() ? 0 : this->regions.back().offset + this->regions.back().size;
+    region.size = size;
+    region.address = address;
+    region.bank = bank;
+
+    this->regions.push_back(region);
+}
+
+const u8* CheatSearch::getRegionData(const SearchRegion& region) {
+    switch(region.type) {
+        case SEARCH_REGION_MAPPED:
+            return this->gameboy->mmu.getWritePointer(region.address);
+        case SEARCH_REGION_WRAM:
+            return this->gameboy->mmu.getWramBank(region.index);
+        case SEARCH_REGION_SRAM:
+            if(this->gameboy->cartridge == nullptr || this->gameboy->cartridge->getSram() == nullptr
+               || region.index >= this->gameboy->cartridge->getRamBanks()) {
+                return nullptr;
+            }
+
+            return this->gameboy->cartridge->getSram() + region.index * SRAM_BANK_SIZE;
+        default:
+            return nullptr;
+    }
+}
+
+const CheatSearch::SearchRegion* CheatSearch::findRegion(u32 position) {
+    for(const SearchRegion& region : this->regions) {
+        if(position >= region.offset && position < region.offset + region.size) {
+            return &region;
+        }
+    }
+
+    return nullptr;
+}
+
+bool CheatSearch::capture(std::vector<u8>& out) {
+    u32 size = this->regions.empty() ? 0 : this->regions.back().offset + this->regions.back().size;
+    out.assign((size + SEARCH_BLOCK_SIZE - 1) & ~(SEARCH_BLOCK_SIZE - 1), 0);
+
+    for(const SearchRegion& region : this->regions) {
+        const u8* data = this->getRegionData(region);
+        if(data == nullptr) {
+            return false;
+        }
+
+        memcpy(&out[region.offset], data, region.size);
+    }
+
+    return true;
+}
+
+void CheatSearch::start() {
+    this->clear();
+
+    if(this->gameboy->cartridge == nullptr) {
+        return;
+    }
+
+    if(this->gameboy->gbMode == MODE_CGB) {
+        this->addRegion(SEARCH_REGION_WRAM, 0, 0x1000, 0xC000, GAMESHARK_BANK_DEFAULT);
+        for(u8 bank = 1; bank < 8; bank++) {
+            this->addRegion(SEARCH_REGION_WRAM, bank, 0x1000, 0xD000, (u8) (GAMESHARK_BANK_WRAM | bank));
+        }
+    } else {
+        // Without bank switching, search whatever is mapped.
+        this->addRegion(SEARCH_REGION_MAPPED, 0, 0x1000, 0xC000, GAMESHARK_BANK_DEFAULT);
+        this->addRegion(SEARCH_REGION_MAPPED, 0, 0x1000, 0xD000, GAMESHARK_BANK_DEFAULT);
+    }
+
+    this->addRegion(SEARCH_REGION_MAPPED, 0, HRAM_SIZE, HRAM_START, GAMESHARK_BANK_DEFAULT);
+
+    // GameShark codes can't select an SRAM bank; codes for these apply to whichever is mapped.
+    for(u8 bank = 0; bank < this->gameboy->cartridge->getRamBanks(); bank++) {
+        this->addRegion(SEARCH_REGION_SRAM, bank, SRAM_BANK_SIZE, 0xA000, GAMESHARK_BANK_DEFAULT);
+    }
+
+    if(!this->capture(this->snapshot)) {
+        this->clear();
+        return;
+    }
+
+    // Every real address starts out as a candidate; the padding at the end never is.
+    u32 size = this->regions.back().offset + this->regions.back().size;
+
+    this->candidates.assign(this->snapshot.size() / SEARCH_BLOCK_SIZE, 0xFFFF);
+    if(size % SEARCH_BLOCK_SIZE != 0) {
+        this->candidates.back() = (u16) ((1 << (size % SEARCH_BLOCK_SIZE)) - 1);
+    }
+
+    this->numCandidates = size;
+}
+
+void CheatSearch::clear() {
+    this->regions.clear();
+    this->snapshot.clear();
+    this->candidates.clear();
+    this->numCandidates = 0;
+}
+
+void CheatSearch::filter(SearchRelation relation, u8 value) {
+    if(!this->isActive()) {
+        return;
+    }
+
+    std::vector<u8> current;
+    if(!this->capture(current)) {
+        this->clear();
+        return;
+    }
+
+    u32 numCandidates = 0;
+
+    u32 numBlocks = (u32) this->candidates.size();
+    for(u32 block = 0; block < numBlocks; block++) {
+        u16 bits = this->candidates[block];
+        if(bits != 0) {
+            u32 offset = block * SEARCH_BLOCK_SIZE;
+            bits &= cheatSearchMatch(relation, &this->snapshot[offset], &current[offset], value);
+
+            this->candidates[block] = bits;
+            numCandidates += cheatSearchPopCount(bits);
+        }
+    }
+
+    this->snapshot.swap(current);
+    this->numCandidates = numCandidates;
+}
+
+u32 CheatSearch::getCandidate(u32 index) {
+    u32 numBlocks = (u32) this->candidates.size();
+    for(u32 block = 0; block < numBlocks; block++) {
+        u16 bits = this->candidates[block];
+
+        u32 count = cheatSearchPopCount(bits);
+        if(index >= count) {
+            index -= count;
+            continue;
+        }
+
+        for(u32 i = 0; i < SEARCH_BLOCK_SIZE; i++) {
+            if(bits & (1 << i)) {
+                if(index == 0) {
+                    return block * SEARCH_BLOCK_SIZE + i;
+                }
+
+                index--;
+            }
+        }
+    }
+
+    return 0;
+}
+
+u16 CheatSearch::getAddress(u32 position) {
+    const SearchRegion* region = this->findRegion(position);
+    return region != nullptr ? (u16) (region->address + position - region->offset) : (u16) 0;
+}
+
+u8 CheatSearch::getBank(u32 position) {
+    const SearchRegion* region = this->findRegion(position);
+    return region != nullptr ? region->bank : (u8) 0;
+}
+
+u8 CheatSearch::getValue(u32 position) {
+    return position < this->snapshot.size() ? this->snapshot[position] : (u8) 0;
+}
+
+const std::string CheatSearch::getCode(u32 position, u8 value) {
+    u16 address = this->getAddress(position);
+
+    // Bank, value, then the address in little endian, as CheatEngine parses them.
+    char code[9];
+    snprintf(code, sizeof(code), "%02X%02X%02X%02X", this->getBank(position), value, address & 0xFF, address >> 8);
+    return code;
+}
+
+const std::string CheatSearch::getRelationName(SearchRelation relation) {
+    static const char* names[NUM_SEARCH_RELATIONS] = {
+            "Equal to",
+            "Not equal to",
+            "Changed",
+            "Unchanged",
+            "Increased",
+            "Decreased",
+            "Increased by",
+            "Decreased by"
+    };
+
+    return relation < NUM_SEARCH_RELATIONS ? names[relation] : "";
+}
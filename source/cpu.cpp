@@ -116,9 +116,6 @@ void CPU::updateEvents() {
     this->gameboy->serial.update();
 }
 
-static u8 temp1 = 0;
-static u8 temp2 = 0;
-
 #define FLAG_ZERO 0x80
 #define FLAG_NEGATIVE 0x40
 #define FLAG_HALFCARRY 0x20
@@ -301,6 +298,10 @@ inline u8 CPU::rot(u8 func, u8 val) {
 }
 
 void CPU::run() {
+    // Scratch values for the memory access macros. These are locals so that separate instances can run on separate threads.
+    u8 temp1 = 0;
+    u8 temp2 = 0;
+
     if(!this->haltState) {
         u8 op = READPC8();
 
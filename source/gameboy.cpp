@@ -14,7 +14,7 @@
 
 static const u8 STATE_VERSION = 13;
 
-Gameboy::Gameboy() : mmu(this), cpu(this), ppu(this), apu(this), sgb(this), timer(this), serial(this), cheatEngine(this) {
+Gameboy::Gameboy() : mmu(this), cpu(this), ppu(this), apu(this), sgb(this), timer(this), serial(this), cheatEngine(this), cheatSearch(this) {
     this->cartridge = nullptr;
 }
 
@@ -29,6 +29,7 @@ void Gameboy::insert(Cartridge* cartridge) {
     }
 
     this->cheatEngine.clearCheats();
+    this->cheatSearch.clear();
 }
 
 void Gameboy::powerOn() {
@@ -126,6 +126,23 @@ void Gb_Apu::reduce_clicks( bool reduce )
 		oscs [i]->dac_off_amp = dac_off_amp;
 }
 
+void Gb_Apu::set_stem_output( Blip_Buffer* center, Blip_Buffer* left, Blip_Buffer* right, int osc )
+{
+	assert( (unsigned) osc < osc_count );
+	
+	if ( !center || !left || !right )
+	{
+		left  = center;
+		right = center;
+	}
+	
+	Gb_Osc& o = *oscs [osc];
+	o.stem_outputs [1] = right;
+	o.stem_outputs [2] = left;
+	o.stem_outputs [3] = center;
+	o.stem_output = o.stem_outputs [calc_output( osc )];
+}
+
 void Gb_Apu::reset()
 {
 	reduce_clicks( reduce_clicks_ );
@@ -188,6 +205,11 @@ Gb_Apu::Gb_Apu(Gameboy* gameboy)
 		o.outputs [3] = 0;
 		o.good_synth  = &good_synth;
 		o.med_synth   = &med_synth;
+		o.stem_output      = 0;
+		o.stem_outputs [0] = 0;
+		o.stem_outputs [1] = 0;
+		o.stem_outputs [2] = 0;
+		o.stem_outputs [3] = 0;
 	}
 	
 	reduce_clicks_ = false;
@@ -274,6 +296,11 @@ void Gb_Apu::silence_osc( Gb_Osc& o )
 				med_synth.offset( last_time, delta, o.output );
 			}
 		}
+		if ( o.stem_output )
+		{
+			o.stem_output->set_modified();
+			med_synth.offset( last_time, delta, o.stem_output );
+		}
 	}
 }
 
@@ -283,10 +310,12 @@ void Gb_Apu::apply_stereo()
 	{
 		Gb_Osc& o = *oscs [i];
 		Blip_Buffer* out = o.outputs [calc_output( i )];
-		if ( o.output != out )
+		Blip_Buffer* stem = o.stem_outputs [calc_output( i )];
+		if ( o.output != out || o.stem_output != stem )
 		{
 			silence_osc( o );
 			o.output = out;
+			o.stem_output = stem;
 		}
 	}
 }
@@ -358,6 +387,92 @@ void Gb_Apu::write_register( s32 time, unsigned addr, int data )
 	}
 }
 
+void Gb_Apu::run_osc( int index, s32 time, s32 end_time )
+{
+	switch ( index )
+	{
+	case 0: square1.run( time, end_time ); break;
+	case 1: square2.run( time, end_time ); break;
+	case 2: wave   .run( time, end_time ); break;
+	case 3: noise  .run( time, end_time ); break;
+	}
+}
+
+int Gb_Apu::reg_osc( unsigned addr ) const
+{
+	// Writes to a powered off APU are filtered by write_register() and don't need catching up
+	if ( !(regs [status_reg - start_addr] & power_mask) )
+		return -1;
+	
+	if ( addr >= wave_ram )
+		return 2;
+	
+	if ( addr < vol_reg )
+		return (addr - start_addr) / 5;
+	
+	return -1;
+}
+
+void Gb_Apu::write_registers( write_t const* writes, int count )
+{
+	// Time each oscillator has been run to while the others are left behind
+	s32 osc_times [osc_count];
+	bool lagging = false;
+	
+	for ( int i = 0; i < count; i++ )
+	{
+		write_t const& w = writes [i];
+		
+		int osc = reg_osc( w.addr );
+		if ( osc >= 0 && w.time <= frame_time )
+		{
+			if ( !lagging )
+			{
+				for ( int j = osc_count; --j >= 0; )
+					osc_times [j] = last_time;
+				lagging = true;
+			}
+			
+			for ( int j = osc_count; --j >= 0; )
+			{
+				// Noise re-phases its timer every time it is run, and squares only
+				// approximate inaudible frequencies from where they start running,
+				// so those have to be run in the same pieces as before.
+				bool split = j == 3 || (j < 2 && (regs [j * 5 + 4] & 7) * 0x100 + regs [j * 5 + 3] >= 0x7FA);
+				if ( (j == osc || split) && w.time > osc_times [j] )
+				{
+					run_osc( j, osc_times [j], w.time );
+					osc_times [j] = w.time;
+				}
+			}
+			
+			// Anything the write itself emits lands at the written oscillator's time
+			if ( w.time > last_time )
+				last_time = w.time;
+		}
+		else if ( lagging )
+		{
+			for ( int j = osc_count; --j >= 0; )
+			{
+				if ( osc_times [j] < last_time )
+					run_osc( j, osc_times [j], last_time );
+			}
+			lagging = false;
+		}
+		
+		write_register( w.time, w.addr, w.data );
+	}
+	
+	if ( lagging )
+	{
+		for ( int j = osc_count; --j >= 0; )
+		{
+			if ( osc_times [j] < last_time )
+				run_osc( j, osc_times [j], last_time );
+		}
+	}
+}
+
 int Gb_Apu::read_register( s32 time, unsigned addr )
 {
 	run_until( time );
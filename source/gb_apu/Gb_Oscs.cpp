@@ -24,6 +24,7 @@ int const length_enabled = 0x40;
 void Gb_Osc::reset()
 {
 	output   = 0;
+	stem_output = 0;
 	last_amp = 0;
 	delay    = 0;
 	phase    = 0;
@@ -33,6 +34,8 @@ void Gb_Osc::reset()
 inline void Gb_Osc::update_amp( s32 time, int new_amp )
 {
 	output->set_modified();
+	if ( stem_output )
+		stem_output->set_modified();
 	int delta = new_amp - last_amp;
 	if ( delta )
 	{
@@ -48,6 +51,9 @@ inline void Gb_Osc::push_sample( const Blip_Synth<quality, range>* synth, s32 ti
 	{
 		synth->offset_inline( time, delta, out );
 	}
+
+	if ( stem_output )
+		synth->offset_inline( time, delta, stem_output );
 }
 
 // Units
@@ -16,6 +16,8 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 
 #include <assert.h>
 
+#include "simd.h"
+
 // Tracked_Blip_Buffer
 
 Tracked_Blip_Buffer::Tracked_Blip_Buffer()
@@ -177,7 +179,7 @@ void Stereo_Mixer::mix_mono( s16* out_, int count )
     BLIP_READER_END( center, *bufs [2] );
 }
 
-void Stereo_Mixer::mix_stereo( s16* out_, int count )
+void Stereo_Mixer::mix_stereo_scalar( s16* out_, int count )
 {
     s16* BLIP_RESTRICT out = out_ + count * 2;
 
@@ -218,4 +220,176 @@ void Stereo_Mixer::mix_stereo( s16* out_, int count )
         BLIP_READER_END( center, *bufs [2] );
         break;
     }
-}
\ No newline at end of file
+}
+
+// The integrators are a serial recurrence in time, so the vector versions run the
+// left, right and center integrators side by side in lanes 0-2, four samples at a
+// time. The sum of two integrators shifted down always fits in 24 bits, where
+// BLIP_CLAMP is the same as a saturating pack.
+
+#if SIMD_SSE2
+
+void Stereo_Mixer::mix_stereo( s16* out, int count )
+{
+    int const bass = BLIP_READER_BASS( *bufs [2] );
+    BLIP_READER_BEGIN( left,   *bufs [0] );
+    BLIP_READER_BEGIN( right,  *bufs [1] );
+    BLIP_READER_BEGIN( center, *bufs [2] );
+
+    // offset goes from negative to zero, as in the scalar mixers
+    BLIP_READER_ADJ_( left,   samples_read );
+    BLIP_READER_ADJ_( right,  samples_read );
+    BLIP_READER_ADJ_( center, samples_read );
+
+    __m128i acc = _mm_set_epi32( 0, center_reader_accum, right_reader_accum, left_reader_accum );
+    __m128i const bass_shift = _mm_cvtsi32_si128( bass );
+    __m128i const zero = _mm_setzero_si128();
+
+    #define BLIP_SSE2_MIX( out ) \
+        __m128i out = _mm_srai_epi32( _mm_add_epi32( acc, _mm_shuffle_epi32( acc, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ), blip_sample_bits - 16 )
+
+    #define BLIP_SSE2_NEXT( in ) \
+        acc = _mm_add_epi32( _mm_sub_epi32( acc, _mm_sra_epi32( acc, bass_shift ) ), in )
+
+    int offset = -count;
+    for ( ; offset <= -4; offset += 4 )
+    {
+        __m128i l = _mm_loadu_si128( (__m128i const*) &left_reader_buf   [offset] );
+        __m128i r = _mm_loadu_si128( (__m128i const*) &right_reader_buf  [offset] );
+        __m128i c = _mm_loadu_si128( (__m128i const*) &center_reader_buf [offset] );
+
+        // transpose into one (left, right, center, 0) vector per sample
+        __m128i lr_lo = _mm_unpacklo_epi32( l, r );
+        __m128i lr_hi = _mm_unpackhi_epi32( l, r );
+        __m128i c_lo  = _mm_unpacklo_epi32( c, zero );
+        __m128i c_hi  = _mm_unpackhi_epi32( c, zero );
+
+        BLIP_SSE2_MIX( s0 );
+        BLIP_SSE2_NEXT( _mm_unpacklo_epi64( lr_lo, c_lo ) );
+        BLIP_SSE2_MIX( s1 );
+        BLIP_SSE2_NEXT( _mm_unpackhi_epi64( lr_lo, c_lo ) );
+        BLIP_SSE2_MIX( s2 );
+        BLIP_SSE2_NEXT( _mm_unpacklo_epi64( lr_hi, c_hi ) );
+        BLIP_SSE2_MIX( s3 );
+        BLIP_SSE2_NEXT( _mm_unpackhi_epi64( lr_hi, c_hi ) );
+
+        __m128i pairs = _mm_packs_epi32( _mm_unpacklo_epi64( s0, s1 ), _mm_unpacklo_epi64( s2, s3 ) );
+        _mm_storeu_si128( (__m128i*) out, pairs );
+        out += 8;
+    }
+
+    #undef BLIP_SSE2_MIX
+    #undef BLIP_SSE2_NEXT
+
+    left_reader_accum   = _mm_cvtsi128_si32( acc );
+    right_reader_accum  = _mm_cvtsi128_si32( _mm_srli_si128( acc, 4 ) );
+    center_reader_accum = _mm_cvtsi128_si32( _mm_srli_si128( acc, 8 ) );
+
+    for ( ; offset; ++offset )
+    {
+        s32 l = (BLIP_READER_READ_RAW( center ) + BLIP_READER_READ_RAW( left  )) >> (blip_sample_bits - 16);
+        s32 r = (BLIP_READER_READ_RAW( center ) + BLIP_READER_READ_RAW( right )) >> (blip_sample_bits - 16);
+        BLIP_READER_NEXT_IDX_( left,   bass, offset );
+        BLIP_READER_NEXT_IDX_( right,  bass, offset );
+        BLIP_READER_NEXT_IDX_( center, bass, offset );
+        BLIP_CLAMP( l, l );
+        BLIP_CLAMP( r, r );
+
+        *out++ = (s16) l;
+        *out++ = (s16) r;
+    }
+
+    BLIP_READER_END( left,   *bufs [0] );
+    BLIP_READER_END( right,  *bufs [1] );
+    BLIP_READER_END( center, *bufs [2] );
+}
+
+#elif SIMD_NEON
+
+void Stereo_Mixer::mix_stereo( s16* out, int count )
+{
+    int const bass = BLIP_READER_BASS( *bufs [2] );
+    BLIP_READER_BEGIN( left,   *bufs [0] );
+    BLIP_READER_BEGIN( right,  *bufs [1] );
+    BLIP_READER_BEGIN( center, *bufs [2] );
+
+    // offset goes from negative to zero, as in the scalar mixers
+    BLIP_READER_ADJ_( left,   samples_read );
+    BLIP_READER_ADJ_( right,  samples_read );
+    BLIP_READER_ADJ_( center, samples_read );
+
+    int32x4_t acc = vdupq_n_s32( 0 );
+    acc = vsetq_lane_s32( left_reader_accum,   acc, 0 );
+    acc = vsetq_lane_s32( right_reader_accum,  acc, 1 );
+    acc = vsetq_lane_s32( center_reader_accum, acc, 2 );
+
+    // shifting left by a negative amount is an arithmetic right shift
+    int32x4_t const bass_shift = vdupq_n_s32( -bass );
+    int32x4_t const zero = vdupq_n_s32( 0 );
+
+    #define BLIP_NEON_MIX( out ) \
+        int32x4_t out = vshrq_n_s32( vaddq_s32( acc, vdupq_lane_s32( vget_high_s32( acc ), 0 ) ), blip_sample_bits - 16 )
+
+    #define BLIP_NEON_NEXT( in ) \
+        acc = vaddq_s32( vsubq_s32( acc, vshlq_s32( acc, bass_shift ) ), in )
+
+    int offset = -count;
+    for ( ; offset <= -4; offset += 4 )
+    {
+        int32x4_t l = vld1q_s32( &left_reader_buf   [offset] );
+        int32x4_t r = vld1q_s32( &right_reader_buf  [offset] );
+        int32x4_t c = vld1q_s32( &center_reader_buf [offset] );
+
+        // transpose into one (left, right, center, 0) vector per sample
+        int32x4x2_t lr = vzipq_s32( l, r );
+        int32x4x2_t cz = vzipq_s32( c, zero );
+
+        BLIP_NEON_MIX( s0 );
+        BLIP_NEON_NEXT( vcombine_s32( vget_low_s32 ( lr.val [0] ), vget_low_s32 ( cz.val [0] ) ) );
+        BLIP_NEON_MIX( s1 );
+        BLIP_NEON_NEXT( vcombine_s32( vget_high_s32( lr.val [0] ), vget_high_s32( cz.val [0] ) ) );
+        BLIP_NEON_MIX( s2 );
+        BLIP_NEON_NEXT( vcombine_s32( vget_low_s32 ( lr.val [1] ), vget_low_s32 ( cz.val [1] ) ) );
+        BLIP_NEON_MIX( s3 );
+        BLIP_NEON_NEXT( vcombine_s32( vget_high_s32( lr.val [1] ), vget_high_s32( cz.val [1] ) ) );
+
+        int16x4_t p01 = vqmovn_s32( vcombine_s32( vget_low_s32( s0 ), vget_low_s32( s1 ) ) );
+        int16x4_t p23 = vqmovn_s32( vcombine_s32( vget_low_s32( s2 ), vget_low_s32( s3 ) ) );
+        vst1q_s16( out, vcombine_s16( p01, p23 ) );
+        out += 8;
+    }
+
+    #undef BLIP_NEON_MIX
+    #undef BLIP_NEON_NEXT
+
+    left_reader_accum   = vgetq_lane_s32( acc, 0 );
+    right_reader_accum  = vgetq_lane_s32( acc, 1 );
+    center_reader_accum = vgetq_lane_s32( acc, 2 );
+
+    for ( ; offset; ++offset )
+    {
+        s32 l = (BLIP_READER_READ_RAW( center ) + BLIP_READER_READ_RAW( left  )) >> (blip_sample_bits - 16);
+        s32 r = (BLIP_READER_READ_RAW( center ) + BLIP_READER_READ_RAW( right )) >> (blip_sample_bits - 16);
+        BLIP_READER_NEXT_IDX_( left,   bass, offset );
+        BLIP_READER_NEXT_IDX_( right,  bass, offset );
+        BLIP_READER_NEXT_IDX_( center, bass, offset );
+        BLIP_CLAMP( l, l );
+        BLIP_CLAMP( r, r );
+
+        *out++ = (s16) l;
+        *out++ = (s16) r;
+    }
+
+    BLIP_READER_END( left,   *bufs [0] );
+    BLIP_READER_END( right,  *bufs [1] );
+    BLIP_READER_END( center, *bufs [2] );
+}
+
+#else
+
+void Stereo_Mixer::mix_stereo( s16* out, int count )
+{
+    mix_stereo_scalar( out, count );
+}
+
+#endif
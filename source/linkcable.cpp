@@ -0,0 +1,190 @@
+#include <chrono>
+#include <thread>
+
+#include "gameboy.h"
+#include "linkcable.h"
+
+#define MAIL_EMPTY 0
+#define MAIL_SENT 1
+#define MAIL_REPLIED 2
+
+// A waiting side yields this many times without the other side's clock moving before it starts
+// sleeping between checks.
+#define WAIT_SPIN_YIELDS 256
+#define WAIT_SLEEP_MICROSECONDS 50
+
+// While the other side is running, its clock keeps moving and waiting only ever yields. Once it
+// stops, for instance to wait for the next frame or while paused, stop burning a core on it.
+static void linkCableWait(u64 otherClock, u64& lastOtherClock, u32& spins) {
+    if(otherClock != lastOtherClock) {
+        lastOtherClock = otherClock;
+        spins = 0;
+    }
+
+    if(spins < WAIT_SPIN_YIELDS) {
+        spins++;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(WAIT_SLEEP_MICROSECONDS));
+    }
+}
+
+LinkCable::LinkCable() {
+    for(u8 side = 0; side < 2; side++) {
+        this->ports[side].cable = this;
+        this->ports[side].side = side;
+
+        this->gameboys[side] = nullptr;
+    }
+
+    this->connected.store(false);
+}
+
+LinkCable::~LinkCable() {
+    this->disconnect();
+
+    for(u8 side = 0; side < 2; side++) {
+        if(this->gameboys[side] != nullptr) {
+            this->gameboys[side]->serial.setLink(nullptr);
+            this->gameboys[side] = nullptr;
+        }
+    }
+}
+
+void LinkCable::connect(Gameboy* first, Gameboy* second) {
+    this->disconnect();
+
+    this->gameboys[0] = first;
+    this->gameboys[1] = second;
+
+    for(u8 side = 0; side < 2; side++) {
+        u64 cycle = this->gameboys[side]->cpu.getCycle();
+
+        this->lastCycles[side] = cycle;
+        this->clockOffsets[side] = 0;
+        this->clocks[side].store(cycle);
+
+        this->mailStates[side].store(MAIL_EMPTY);
+        this->mailClocks[side] = 0;
+        this->mailData[side] = 0xFF;
+        this->mailReplies[side] = 0xFF;
+
+        this->gameboys[side]->serial.setLink(&this->ports[side]);
+    }
+
+    // Start both clocks level, so neither side has to wait out the other's head start.
+    if(this->lastCycles[0] > this->lastCycles[1]) {
+        this->clockOffsets[1] = this->lastCycles[0] - this->lastCycles[1];
+        this->clocks[1].store(this->lastCycles[0]);
+    } else {
+        this->clockOffsets[0] = this->lastCycles[1] - this->lastCycles[0];
+        this->clocks[0].store(this->lastCycles[1]);
+    }
+
+    this->connected.store(true, std::memory_order_release);
+}
+
+void LinkCable::disconnect() {
+    // Safe from any thread; releases a side that is waiting on one that has stopped.
+    this->connected.store(false, std::memory_order_release);
+}
+
+u64 LinkCable::Port::sync(u64 cycle) {
+    this->cable->sync(this->side, cycle);
+    return cycle + LINK_QUANTUM_CYCLES;
+}
+
+u8 LinkCable::Port::transfer(u64 cycle, u8 val) {
+    return this->cable->transfer(this->side, cycle, val);
+}
+
+bool LinkCable::Port::poll(u64 cycle, u8 val, u8* received) {
+    return this->cable->poll(this->side, cycle, val, received);
+}
+
+void LinkCable::sync(u8 side, u64 cycle) {
+    if(!this->connected.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    u64 clock = this->updateClock(side, cycle);
+    this->receive(side, clock);
+
+    u8 other = (u8) (side ^ 1);
+    u64 otherClock = 0;
+    u32 spins = 0;
+    while(clock > this->clocks[other].load(std::memory_order_acquire) + LINK_QUANTUM_CYCLES) {
+        if(!this->connected.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        // The other side may be waiting on a byte it sent while catching up.
+        this->receive(side, clock);
+        linkCableWait(this->clocks[other].load(std::memory_order_relaxed), otherClock, spins);
+    }
+}
+
+u8 LinkCable::transfer(u8 side, u64 cycle, u8 data) {
+    if(!this->connected.load(std::memory_order_acquire)) {
+        return 0xFF;
+    }
+
+    u64 clock = this->updateClock(side, cycle);
+
+    u8 other = (u8) (side ^ 1);
+    this->mailClocks[other] = clock;
+    this->mailData[other] = data;
+    this->mailStates[other].store(MAIL_SENT, std::memory_order_release);
+
+    u64 otherClock = 0;
+    u32 spins = 0;
+    while(this->mailStates[other].load(std::memory_order_acquire) != MAIL_REPLIED) {
+        if(!this->connected.load(std::memory_order_acquire)) {
+            return 0xFF;
+        }
+
+        // Both sides may be driving the clock at once; answer the other side before waiting on it.
+        this->receive(side, UINT64_MAX);
+        linkCableWait(this->clocks[other].load(std::memory_order_relaxed), otherClock, spins);
+    }
+
+    u8 reply = this->mailReplies[other];
+    this->mailStates[other].store(MAIL_EMPTY, std::memory_order_relaxed);
+    return reply;
+}
+
+bool LinkCable::poll(u8 side, u64 cycle, u8 data, u8* received) {
+    if(!this->connected.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    u64 clock = this->updateClock(side, cycle);
+    if(this->mailStates[side].load(std::memory_order_acquire) != MAIL_SENT || this->mailClocks[side] > clock) {
+        return false;
+    }
+
+    *received = this->mailData[side];
+
+    this->mailReplies[side] = data;
+    this->mailStates[side].store(MAIL_REPLIED, std::memory_order_release);
+    return true;
+}
+
+u64 LinkCable::updateClock(u8 side, u64 cycle) {
+    if(cycle < this->lastCycles[side]) {
+        this->clockOffsets[side] += this->lastCycles[side] - cycle;
+    }
+
+    this->lastCycles[side] = cycle;
+
+    u64 clock = cycle + this->clockOffsets[side];
+    this->clocks[side].store(clock, std::memory_order_release);
+    return clock;
+}
+
+void LinkCable::receive(u8 side, u64 clock) {
+    if(this->mailStates[side].load(std::memory_order_acquire) == MAIL_SENT && this->mailClocks[side] <= clock) {
+        this->mailReplies[side] = this->gameboys[side]->serial.linkReceive(this->mailData[side]);
+        this->mailStates[side].store(MAIL_REPLIED, std::memory_order_release);
+    }
+}
@@ -85,12 +85,14 @@ static const u8 initialHramCGB[0x100] = {
 
 MMU::MMU(Gameboy* gameboy) {
     this->gameboy = gameboy;
+    this->mapGeneration = 0;
 }
 
 void MMU::reset() {
     memset(this->pages, 0, sizeof(this->pages));
     memset(this->pageRead, 0, sizeof(this->pageRead));
     memset(this->pageWrite, 0, sizeof(this->pageWrite));
+    this->mapGeneration++;
 
     for(int i = 0; i < 8; i++) {
         memset(this->wram[i], 0, sizeof(this->wram[i]));
@@ -188,6 +190,8 @@ void MMU::write(u16 addr, u8 val) {
                 mbcWrite writeSram = this->gameboy->cartridge->getWriteSramFunc();
                 if(writeSram != nullptr) {
                     (this->gameboy->cartridge->*writeSram)(addr, val);
+                } else {
+                    this->gameboy->cartridge->writeSramPage(addr, val);
                 }
             }
 
@@ -70,6 +70,14 @@ u32 audioGetSampleRate() {
     return 44100;
 }
 
+double audioGetRateScale() {
+    return 1;
+}
+
+bool audioWaitForFrame() {
+    return false;
+}
+
 void audioPlay(u32* buffer, long samples) {
     if(!initialized) {
         return;
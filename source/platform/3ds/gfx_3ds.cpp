@@ -518,4 +518,8 @@ void gfxDrawScreen() {
     C3D_FrameEnd(0);
 }
 
+bool gfxSetVsync(bool vsync) {
+    return false;
+}
+
 #endif
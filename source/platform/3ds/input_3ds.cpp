@@ -203,6 +203,10 @@ void inputReleaseAll() {
     }
 }
 
+bool inputPlayerKeyHeld(u32 player, u32 key) {
+    return player == 0 && inputKeyHeld(key);
+}
+
 void inputGetMotionSensor(u16* x, u16* y) {
     accelVector vec;
     hidAccelRead(&vec);
@@ -0,0 +1,93 @@
+#include <string>
+
+#include "libs/stb_image/stb_image.h"
+
+#include "platform/common/camera.h"
+
+#define CAMERA_IMAGE_PIXELS (CAMERA_IMAGE_WIDTH * CAMERA_IMAGE_HEIGHT)
+
+static CameraSource currSource = CAMERA_SOURCE_OFF;
+static u32 image[CAMERA_IMAGE_PIXELS];
+static u32 patternFrame = 0;
+
+static inline u32 cameraPixel(u8 r, u8 g, u8 b) {
+    return (u32) (r | (g << 8) | (b << 16));
+}
+
+static bool cameraLoadImage(const std::string& path) {
+    int imgWidth;
+    int imgHeight;
+    int imgDepth;
+    u8* data = stbi_load(path.c_str(), &imgWidth, &imgHeight, &imgDepth, STBI_rgb);
+    if(data == nullptr) {
+        return false;
+    }
+
+    // Crop the middle of the image to the sensor's aspect ratio, then sample it down to size.
+    int cropWidth = imgWidth;
+    int cropHeight = imgHeight;
+    if(imgWidth * CAMERA_IMAGE_HEIGHT > imgHeight * CAMERA_IMAGE_WIDTH) {
+        cropWidth = imgHeight * CAMERA_IMAGE_WIDTH / CAMERA_IMAGE_HEIGHT;
+    } else {
+        cropHeight = imgWidth * CAMERA_IMAGE_HEIGHT / CAMERA_IMAGE_WIDTH;
+    }
+
+    int cropX = (imgWidth - cropWidth) / 2;
+    int cropY = (imgHeight - cropHeight) / 2;
+
+    for(int y = 0; y < CAMERA_IMAGE_HEIGHT; y++) {
+        u8* srcLine = &data[(cropY + y * cropHeight / CAMERA_IMAGE_HEIGHT) * imgWidth * 3];
+        u32* dstLine = &image[y * CAMERA_IMAGE_WIDTH];
+
+        for(int x = 0; x < CAMERA_IMAGE_WIDTH; x++) {
+            u8* src = &srcLine[(cropX + x * cropWidth / CAMERA_IMAGE_WIDTH) * 3];
+            dstLine[x] = cameraPixel(src[0], src[1], src[2]);
+        }
+    }
+
+    stbi_image_free(data);
+    return true;
+}
+
+static void cameraDrawPattern() {
+    // Checkerboard scrolling diagonally over a horizontal gradient, so that motion and every
+    // exposure level show up in the preview.
+    for(int y = 0; y < CAMERA_IMAGE_HEIGHT; y++) {
+        u32* line = &image[y * CAMERA_IMAGE_WIDTH];
+
+        for(int x = 0; x < CAMERA_IMAGE_WIDTH; x++) {
+            u8 level = (u8) (x * 2);
+            if((((x + patternFrame) >> 4) ^ ((y + patternFrame) >> 4)) & 1) {
+                level = (u8) (255 - level);
+            }
+
+            line[x] = cameraPixel(level, level, level);
+        }
+    }
+
+    patternFrame++;
+}
+
+bool cameraSetSource(CameraSource source, const std::string& imagePath) {
+    currSource = CAMERA_SOURCE_OFF;
+
+    if(source == CAMERA_SOURCE_IMAGE && !cameraLoadImage(imagePath)) {
+        return false;
+    }
+
+    currSource = source;
+    patternFrame = 0;
+    return true;
+}
+
+u32* cameraGetImage() {
+    switch(currSource) {
+        case CAMERA_SOURCE_IMAGE:
+            return image;
+        case CAMERA_SOURCE_PATTERN:
+            cameraDrawPattern();
+            return image;
+        default:
+            return nullptr;
+    }
+}
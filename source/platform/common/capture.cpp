@@ -0,0 +1,398 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "platform/common/capture.h"
+#include "gameboy.h"
+#include "ppu.h"
+
+// Frames are handed to the encoder thread through a small ring of preallocated slots.
+// The emulator never waits on it; if every slot is full, the frame is dropped and the
+// encoder repeats the previous frame in its place so the video keeps its frame rate.
+#define CAPTURE_SLOTS 8
+
+// Audio has its own rings so that dropping a frame never drops the sound that went with it.
+// If a ring fills up anyway, the samples that don't fit are replaced with as much silence.
+#define CAPTURE_AUDIO_SAMPLES 65536
+// The mix, plus one stem for each channel.
+#define CAPTURE_MAX_TRACKS 5
+
+#define CAPTURE_IDLE_MS 2
+
+#define CAPTURE_FRAME_PIXELS (GB_FRAME_WIDTH * GB_FRAME_HEIGHT)
+
+#define WAV_HEADER_SIZE 44
+
+static bool recording = false;
+
+typedef struct {
+    std::ofstream stream;
+    u32 bytes;
+
+    u32* ring;
+    std::atomic<u32> read;
+    std::atomic<u32> write;
+
+    // Samples dropped since the last gap was handed to the encoder.
+    u32 droppedSamples;
+    // Silence to write once the encoder reaches gapPosition in the ring.
+    u32 gapPosition;
+    std::atomic<u32> gapSamples;
+} AudioTrack;
+
+static std::ofstream videoStream;
+
+static u32* slots[CAPTURE_SLOTS];
+static u32 slotRepeats[CAPTURE_SLOTS];
+static std::atomic<u32> slotRead(0);
+static std::atomic<u32> slotWrite(0);
+
+static AudioTrack tracks[CAPTURE_MAX_TRACKS];
+static u32 numTracks = 0;
+
+static std::thread encoder;
+static std::atomic<bool> stopRequested(false);
+
+static u32 sampleRate;
+static u32 silenceRemainder;
+
+static u32 droppedFrames;
+static u32 pendingRepeats;
+
+static std::vector<u8> planes;
+
+static void captureWrite32(std::ostream& stream, u32 value) {
+    stream.write((const char*) &value, sizeof(value));
+}
+
+static void captureWrite16(std::ostream& stream, u16 value) {
+    stream.write((const char*) &value, sizeof(value));
+}
+
+static void captureWriteWavHeader(AudioTrack& track) {
+    std::ofstream& stream = track.stream;
+
+    stream.seekp(0);
+
+    stream.write("RIFF", 4);
+    captureWrite32(stream, WAV_HEADER_SIZE - 8 + track.bytes);
+    stream.write("WAVE", 4);
+
+    stream.write("fmt ", 4);
+    captureWrite32(stream, 16);
+    captureWrite16(stream, 1);
+    captureWrite16(stream, 2);
+    captureWrite32(stream, sampleRate);
+    captureWrite32(stream, sampleRate * sizeof(u32));
+    captureWrite16(stream, sizeof(u32));
+    captureWrite16(stream, 16);
+
+    stream.write("data", 4);
+    captureWrite32(stream, track.bytes);
+}
+
+// Frames are stored as 4:4:4 so the GameBoy's hard pixel edges survive without chroma bleed.
+static void captureConvertFrame(const u32* frame) {
+    u8* y = &planes[0];
+    u8* u = &planes[CAPTURE_FRAME_PIXELS];
+    u8* v = &planes[CAPTURE_FRAME_PIXELS * 2];
+
+    for(u32 i = 0; i < CAPTURE_FRAME_PIXELS; i++) {
+        s32 r = (frame[i] >> 24) & 0xFF;
+        s32 g = (frame[i] >> 16) & 0xFF;
+        s32 b = (frame[i] >> 8) & 0xFF;
+
+        // BT.601, studio range.
+        y[i] = (u8) (((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u[i] = (u8) (((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[i] = (u8) (((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+static void captureWriteFrame() {
+    videoStream.write("FRAME\n", 6);
+    videoStream.write((const char*) &planes[0], planes.size());
+}
+
+static bool captureEncodeFrames() {
+    u32 read = slotRead.load(std::memory_order_relaxed);
+    u32 write = slotWrite.load(std::memory_order_acquire);
+    if(read == write) {
+        return false;
+    }
+
+    for(; read != write; read++) {
+        u32 slot = read % CAPTURE_SLOTS;
+
+        // Stand in for frames that were dropped before this one with the last frame encoded.
+        for(u32 i = 0; i < slotRepeats[slot]; i++) {
+            captureWriteFrame();
+        }
+
+        captureConvertFrame(slots[slot]);
+        captureWriteFrame();
+
+        slotRead.store(read + 1, std::memory_order_release);
+    }
+
+    return true;
+}
+
+static void captureWriteSilence(AudioTrack& track, u32 samples) {
+    static const u32 silence[1024] = {0};
+
+    while(samples > 0) {
+        u32 count = samples < 1024 ? samples : 1024;
+        track.stream.write((const char*) silence, count * sizeof(u32));
+        track.bytes += count * sizeof(u32);
+
+        samples -= count;
+    }
+}
+
+static bool captureEncodeAudio(AudioTrack& track) {
+    u32 read = track.read.load(std::memory_order_relaxed);
+    u32 write = track.write.load(std::memory_order_acquire);
+    u32 gap = track.gapSamples.load(std::memory_order_acquire);
+    if(read == write && (gap == 0 || track.gapPosition != read)) {
+        return false;
+    }
+
+    while(true) {
+        // Stand in for samples that were dropped here with silence, so the WAV keeps in step with the video.
+        if(gap > 0 && track.gapPosition == read) {
+            captureWriteSilence(track, gap);
+
+            track.gapSamples.store(0, std::memory_order_release);
+            gap = 0;
+        }
+
+        if(read == write) {
+            break;
+        }
+
+        u32 index = read % CAPTURE_AUDIO_SAMPLES;
+        u32 count = write - read;
+        if(count > CAPTURE_AUDIO_SAMPLES - index) {
+            count = CAPTURE_AUDIO_SAMPLES - index;
+        }
+
+        if(gap > 0 && track.gapPosition - read < count) {
+            count = track.gapPosition - read;
+        }
+
+        // Samples are already interleaved signed 16-bit stereo, which is what WAV wants.
+        track.stream.write((const char*) &track.ring[index], count * sizeof(u32));
+        track.bytes += count * sizeof(u32);
+
+        read += count;
+        track.read.store(read, std::memory_order_release);
+    }
+
+    return true;
+}
+
+static void captureEncoderThread() {
+    while(true) {
+        // Check for a stop before draining, so everything queued ahead of it is written out.
+        bool stopping = stopRequested.load(std::memory_order_acquire);
+
+        bool busy = captureEncodeFrames();
+        for(u32 i = 0; i < numTracks; i++) {
+            busy |= captureEncodeAudio(tracks[i]);
+        }
+
+        if(!busy) {
+            if(stopping) {
+                break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(CAPTURE_IDLE_MS));
+        }
+    }
+}
+
+static void capturePushAudio(AudioTrack& track, const u32* audio, u32 samples) {
+    u32 read = track.read.load(std::memory_order_acquire);
+    u32 write = track.write.load(std::memory_order_relaxed);
+
+    // Once the encoder has taken the last gap, hand it one for anything dropped since, ahead of these samples.
+    if(track.droppedSamples > 0 && track.gapSamples.load(std::memory_order_acquire) == 0) {
+        track.gapPosition = write;
+        track.gapSamples.store(track.droppedSamples, std::memory_order_release);
+        track.droppedSamples = 0;
+    }
+
+    // Until then, these samples have to be dropped too, or they would be written ahead of the gap.
+    u32 count = 0;
+    if(track.droppedSamples == 0) {
+        u32 space = CAPTURE_AUDIO_SAMPLES - (write - read);
+        count = samples < space ? samples : space;
+    }
+
+    for(u32 i = 0; i < count; i++) {
+        track.ring[(write + i) % CAPTURE_AUDIO_SAMPLES] = audio != nullptr ? audio[i] : 0;
+    }
+
+    track.write.store(write + count, std::memory_order_release);
+    track.droppedSamples += samples - count;
+}
+
+static void captureCloseStreams() {
+    videoStream.close();
+
+    for(u32 i = 0; i < numTracks; i++) {
+        tracks[i].stream.close();
+
+        delete[] tracks[i].ring;
+        tracks[i].ring = nullptr;
+    }
+
+    numTracks = 0;
+}
+
+bool captureStart(const std::string& videoPath, const std::vector<std::string>& audioPaths, u32 rate) {
+    captureStop();
+
+    if(rate == 0 || audioPaths.empty() || audioPaths.size() > CAPTURE_MAX_TRACKS) {
+        return false;
+    }
+
+    sampleRate = rate;
+    silenceRemainder = 0;
+
+    videoStream.open(videoPath, std::ios::binary | std::ios::trunc);
+
+    bool opened = videoStream.is_open();
+    for(const std::string& path : audioPaths) {
+        AudioTrack& track = tracks[numTracks++];
+        track.stream.open(path, std::ios::binary | std::ios::trunc);
+        track.bytes = 0;
+        track.ring = new u32[CAPTURE_AUDIO_SAMPLES];
+        track.read.store(0);
+        track.write.store(0);
+
+        track.droppedSamples = 0;
+        track.gapPosition = 0;
+        track.gapSamples.store(0);
+
+        opened = opened && track.stream.is_open();
+    }
+
+    if(!opened) {
+        captureCloseStreams();
+        return false;
+    }
+
+    droppedFrames = 0;
+    pendingRepeats = 0;
+
+    videoStream << "YUV4MPEG2 W" << GB_FRAME_WIDTH << " H" << GB_FRAME_HEIGHT << " F" << CYCLES_PER_SECOND << ":" << CYCLES_PER_FRAME << " Ip A1:1 C444\n";
+
+    bool good = videoStream.good();
+    for(u32 i = 0; i < numTracks; i++) {
+        captureWriteWavHeader(tracks[i]);
+        good = good && tracks[i].stream.good();
+    }
+
+    if(!good) {
+        captureCloseStreams();
+        return false;
+    }
+
+    planes.assign(CAPTURE_FRAME_PIXELS * 3, 0);
+    for(u32 i = 0; i < CAPTURE_SLOTS; i++) {
+        slots[i] = new u32[CAPTURE_FRAME_PIXELS];
+    }
+
+    slotRead.store(0);
+    slotWrite.store(0);
+    stopRequested.store(false);
+
+    encoder = std::thread(captureEncoderThread);
+
+    recording = true;
+    return true;
+}
+
+void captureStop() {
+    if(!recording) {
+        return;
+    }
+
+    recording = false;
+
+    stopRequested.store(true, std::memory_order_release);
+    encoder.join();
+
+    // Account for frames dropped after the last one that made it into the queue.
+    for(u32 i = 0; i < pendingRepeats; i++) {
+        captureWriteFrame();
+    }
+
+    // Likewise for samples dropped after the last gap the encoder was handed.
+    for(u32 i = 0; i < numTracks; i++) {
+        captureWriteSilence(tracks[i], tracks[i].droppedSamples);
+        captureWriteWavHeader(tracks[i]);
+    }
+
+    captureCloseStreams();
+
+    for(u32 i = 0; i < CAPTURE_SLOTS; i++) {
+        delete[] slots[i];
+        slots[i] = nullptr;
+    }
+
+    planes.clear();
+    planes.shrink_to_fit();
+}
+
+bool captureIsRecording() {
+    return recording;
+}
+
+u32 captureGetDroppedFrames() {
+    return droppedFrames;
+}
+
+void captureFrame(const u32* frame, u32 pitch, const u32* const* audio, long samples) {
+    if(!recording) {
+        return;
+    }
+
+    if(samples > 0) {
+        for(u32 i = 0; i < numTracks; i++) {
+            capturePushAudio(tracks[i], audio[i], (u32) samples);
+        }
+    } else {
+        // No sound was synthesized this frame; keep the WAVs in step with the video anyway.
+        u64 scaled = (u64) sampleRate * CYCLES_PER_FRAME + silenceRemainder;
+        silenceRemainder = (u32) (scaled % CYCLES_PER_SECOND);
+
+        for(u32 i = 0; i < numTracks; i++) {
+            capturePushAudio(tracks[i], nullptr, (u32) (scaled / CYCLES_PER_SECOND));
+        }
+    }
+
+    u32 read = slotRead.load(std::memory_order_acquire);
+    u32 write = slotWrite.load(std::memory_order_relaxed);
+    if(write - read >= CAPTURE_SLOTS) {
+        droppedFrames++;
+        pendingRepeats++;
+        return;
+    }
+
+    u32 slot = write % CAPTURE_SLOTS;
+
+    for(u32 y = 0; y < GB_FRAME_HEIGHT; y++) {
+        memcpy(&slots[slot][y * GB_FRAME_WIDTH], &frame[y * pitch], GB_FRAME_WIDTH * sizeof(u32));
+    }
+
+    slotRepeats[slot] = pendingRepeats;
+    pendingRepeats = 0;
+
+    slotWrite.store(write + 1, std::memory_order_release);
+}
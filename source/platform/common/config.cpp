@@ -164,9 +164,60 @@ static ConfigGroup gameBoy = {
                         {"Off", "On"},
                         GB_PRINTER_ON,
                         nullptr
-                }
+                },
+                {
+                        "Auto Save",
+                        {"Off", "On"},
+                        AUTO_SAVE_ON,
+                        nullptr
+                },
+#ifdef GAMEBOY_MAPPED_SAVES
+                {
+                        "Mapped Saves",
+                        {"Off", "On"},
+                        MAPPED_SAVES_OFF,
+                        nullptr
+                },
+                {
+                        "Mapped ROMs",
+                        {"Off", "On"},
+                        MAPPED_ROMS_ON,
+                        nullptr
+                },
+#endif
+#ifdef GAMEBOY_CAMERA_SOURCE
+                {
+                        "Camera Source",
+                        {"Off", "Image File", "Test Pattern"},
+                        CAMERA_SOURCE_OPTION_OFF,
+                        mgrRefreshCamera
+                },
+#endif
+#ifdef GAMEBOY_LINK_CABLE
+                {
+                        "Link Cable",
+                        {"Off", "Host", "Join", "Local"},
+                        LINK_CABLE_OFF,
+                        mgrRefreshLink
+                },
+                {
+                        "Link Transport",
+                        {"Local Socket", "TCP Loopback"},
+                        LINK_TRANSPORT_LOCAL,
+                        mgrRefreshLink
+                },
+#endif
         },
-        {}
+        {
+#ifdef GAMEBOY_CAMERA_IMAGE_PATH
+                {
+                        "Camera Image Path",
+                        {"jpg", "jpeg", "png", "bmp", "psd", "tga", "gif", "hdr", "pic", "ppm", "pgm"},
+                        "",
+                        mgrRefreshCamera
+                },
+#endif
+        }
 };
 
 static ConfigGroup display = {
@@ -219,7 +270,15 @@ static ConfigGroup display = {
                         {"Pre-Scaled", "Scale Base"},
                         CUSTOM_BORDERS_SCALING_PRE_SCALED,
                         mgrRefreshBorder
-                }
+                },
+#ifdef DISPLAY_FRAME_PACING
+                {
+                        "Frame Pacing",
+                        {"Timer", "Audio", "VSync"},
+                        FRAME_PACING_TIMER,
+                        mgrRefreshPacing
+                },
+#endif
         },
         {
                 {
@@ -263,7 +322,27 @@ static ConfigGroup sound = {
                         {"Off", "On"},
                         SOUND_ON,
                         nullptr
-                }
+                },
+                {
+                        "Capture Channels",
+                        {"Off", "On"},
+                        SOUND_OFF,
+                        nullptr
+                },
+#ifdef SOUND_OUTPUT_RATE
+                {
+                        "Output Rate",
+                        {"Device", "32768", "44100", "48000", "96000"},
+                        SAMPLE_RATE_AUTO,
+                        mgrRefreshAudio
+                },
+                {
+                        "Internal Rate",
+                        {"Off", "32768", "44100", "48000", "96000"},
+                        SAMPLE_RATE_AUTO,
+                        mgrRefreshAudio
+                },
+#endif
         },
         {}
 };
@@ -0,0 +1,266 @@
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <unordered_map>
+
+#include "platform/common/dirscanner.h"
+
+// Entries are handed to the menu in batches, so a large directory starts showing before it has been read in full.
+#define DIR_SCAN_BATCH_SIZE 64
+
+#define CACHE_FILE "gameyob.dir"
+
+#define CACHE_MAGIC "GYDC"
+#define CACHE_VERSION 2
+
+// Listings of directories changed this recently may not show everything in them yet, as a change
+// made within the same timestamp tick would go unnoticed.
+#define CACHE_SETTLE_SECONDS 2
+
+typedef struct {
+    s64 mtime; // In nanoseconds.
+    std::vector<DirScanEntry> entries;
+} DirScanCache;
+
+static std::mutex cacheMutex;
+static std::unordered_map<std::string, DirScanCache> cache;
+static bool cacheDirty = false;
+
+static s64 dirScannerGetMtime(const struct stat& st) {
+#if defined(__APPLE__)
+    return (s64) st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    return (s64) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    return (s64) st.st_mtime * 1000000000;
+#endif
+}
+
+DirScanner::DirScanner() {
+    this->cancel.store(false);
+    this->finished = true;
+}
+
+DirScanner::~DirScanner() {
+    this->stop();
+}
+
+void DirScanner::start(const std::vector<std::string>& directories) {
+    this->stop();
+
+    this->results.clear();
+    this->finished = false;
+
+    this->cancel.store(false);
+    this->thread = std::thread(&DirScanner::run, this, directories);
+}
+
+void DirScanner::stop() {
+    if(this->thread.joinable()) {
+        this->cancel.store(true);
+        this->thread.join();
+    }
+}
+
+bool DirScanner::poll(std::vector<DirScanEntry>& entries) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    entries.insert(entries.end(), this->results.begin(), this->results.end());
+    this->results.clear();
+
+    return this->finished;
+}
+
+void DirScanner::publish(std::vector<DirScanEntry>& batch) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->results.insert(this->results.end(), batch.begin(), batch.end());
+    batch.clear();
+}
+
+void DirScanner::run(std::vector<std::string> directories) {
+    std::vector<DirScanEntry> batch;
+
+    for(u32 i = 0; i < directories.size() && !this->cancel.load(); i++) {
+        const std::string& directory = directories[i];
+
+        struct stat st;
+        if(stat(directory.c_str(), &st) != 0) {
+            continue;
+        }
+
+        s64 mtime = dirScannerGetMtime(st);
+        bool cached = false;
+
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+
+            auto it = cache.find(directory);
+            if(it != cache.end() && it->second.mtime == mtime) {
+                for(const DirScanEntry& entry : it->second.entries) {
+                    batch.push_back({entry.name, i, entry.isDirectory});
+                }
+
+                cached = true;
+            }
+        }
+
+        if(cached) {
+            this->publish(batch);
+            continue;
+        }
+
+        DIR* dir = opendir(directory.c_str());
+        if(dir == nullptr) {
+            continue;
+        }
+
+        std::vector<DirScanEntry> listing;
+
+        dirent* entry;
+        while(!this->cancel.load() && (entry = readdir(dir)) != nullptr) {
+            if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+
+            listing.push_back({entry->d_name, i, (entry->d_type & DT_DIR) != 0});
+            batch.push_back(listing.back());
+
+            if(batch.size() >= DIR_SCAN_BATCH_SIZE) {
+                this->publish(batch);
+            }
+        }
+
+        closedir(dir);
+
+        this->publish(batch);
+
+        // Don't cache a listing that was cut short, or one that may already be missing something.
+        if(!this->cancel.load() && (s64) time(nullptr) - st.st_mtime >= CACHE_SETTLE_SECONDS) {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            cache[directory] = {mtime, listing};
+            cacheDirty = true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->finished = true;
+}
+
+template<typename T>
+static bool dirScannerReadValue(std::istream& stream, T* value) {
+    stream.read((char*) value, sizeof(T));
+    return stream.good();
+}
+
+template<typename T>
+static void dirScannerWriteValue(std::ostream& stream, const T& value) {
+    stream.write((const char*) &value, sizeof(T));
+}
+
+static bool dirScannerReadString(std::istream& stream, std::string* str) {
+    u16 length = 0;
+    if(!dirScannerReadValue(stream, &length)) {
+        return false;
+    }
+
+    str->resize(length);
+    stream.read(&(*str)[0], length);
+    return stream.good();
+}
+
+static void dirScannerWriteString(std::ostream& stream, const std::string& str) {
+    dirScannerWriteValue(stream, (u16) str.length());
+    stream.write(str.data(), str.length());
+}
+
+void dirScannerLoadCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    cache.clear();
+    cacheDirty = false;
+
+    std::ifstream stream(CACHE_FILE, std::ios::binary);
+    if(!stream.is_open()) {
+        return;
+    }
+
+    char magic[4] = {0};
+    u8 fileVersion = 0;
+    u32 count = 0;
+
+    stream.read(magic, sizeof(magic));
+    if(memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || !dirScannerReadValue(stream, &fileVersion) || fileVersion != CACHE_VERSION || !dirScannerReadValue(stream, &count)) {
+        return;
+    }
+
+    for(u32 i = 0; i < count; i++) {
+        std::string directory;
+        s64 mtime = 0;
+        u32 entryCount = 0;
+
+        if(!dirScannerReadString(stream, &directory) || !dirScannerReadValue(stream, &mtime) || !dirScannerReadValue(stream, &entryCount)) {
+            break;
+        }
+
+        DirScanCache listing = {mtime, {}};
+
+        bool complete = true;
+        for(u32 j = 0; j < entryCount; j++) {
+            DirScanEntry entry = {"", 0, false};
+            u8 isDirectory = 0;
+
+            if(!dirScannerReadString(stream, &entry.name) || !dirScannerReadValue(stream, &isDirectory)) {
+                complete = false;
+                break;
+            }
+
+            entry.isDirectory = isDirectory != 0;
+            listing.entries.push_back(entry);
+        }
+
+        // A listing cut short by a truncated file would hide entries, so drop it.
+        if(!complete) {
+            break;
+        }
+
+        cache[directory] = std::move(listing);
+    }
+}
+
+void dirScannerSaveCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    if(!cacheDirty) {
+        return;
+    }
+
+    std::ofstream stream(CACHE_FILE, std::ios::binary | std::ios::trunc);
+    if(!stream.is_open()) {
+        return;
+    }
+
+    stream.write(CACHE_MAGIC, 4);
+    dirScannerWriteValue(stream, (u8) CACHE_VERSION);
+    dirScannerWriteValue(stream, (u32) cache.size());
+
+    for(const auto& it : cache) {
+        const DirScanCache& listing = it.second;
+
+        dirScannerWriteString(stream, it.first);
+        dirScannerWriteValue(stream, listing.mtime);
+        dirScannerWriteValue(stream, (u32) listing.entries.size());
+
+        for(const DirScanEntry& entry : listing.entries) {
+            dirScannerWriteString(stream, entry.name);
+            dirScannerWriteValue(stream, (u8) entry.isDirectory);
+        }
+    }
+
+    if(stream.good()) {
+        cacheDirty = false;
+    }
+}
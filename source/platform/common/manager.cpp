@@ -7,12 +7,29 @@
 #include <unistd.h>
 #endif
 
+#if defined(BACKEND_SDL) && !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include <algorithm>
 #include <chrono>
+#include <ctime>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 
+#ifdef BACKEND_SDL
+#include <thread>
+#endif
+
+#if defined(BACKEND_SDL) && !defined(WIN32)
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#endif
+
 #include "libs/inih/INIReader.h"
 #include "libs/stb_image/stb_image.h"
 
@@ -21,6 +38,13 @@
 #include "platform/common/menu/menu.h"
 #include "platform/common/config.h"
 #include "platform/common/manager.h"
+#include "platform/common/camera.h"
+#include "platform/common/capture.h"
+#include "platform/common/dirscanner.h"
+#include "platform/common/movie.h"
+#include "platform/common/netlink.h"
+#include "platform/common/printout.h"
+#include "platform/common/romindex.h"
 #include "platform/audio.h"
 #include "platform/gfx.h"
 #include "platform/input.h"
@@ -28,8 +52,10 @@
 #include "platform/ui.h"
 #include "cartridge.h"
 #include "gameboy.h"
+#include "linkcable.h"
 #include "mmu.h"
 #include "ppu.h"
+#include "romimage.h"
 #include "sgb.h"
 
 #define RGBA32(r, g, b) ((u32) ((r) << 24 | (g) << 16 | (b) << 8 | 0xFF))
@@ -483,27 +509,46 @@ static const u32* findPalette(const std::string& title) {
 
 #define NS_PER_FRAME ((s64) (1000000000.0 / ((double) CYCLES_PER_SECOND / (double) CYCLES_PER_FRAME)))
 
+// Sleep until this close to a frame deadline, then spin the rest of the way.
+#define NS_SLEEP_MARGIN ((s64) 1000000)
+// If we fall further behind than this, give up catching up and start pacing from now.
+#define MAX_FRAMES_BEHIND 4
+
+// Flush dirty SRAM once the game has stopped writing for a second, or after ten seconds of continuous writes.
+#define AUTO_SAVE_IDLE_CYCLES ((u64) CYCLES_PER_SECOND)
+#define AUTO_SAVE_MAX_CYCLES ((u64) CYCLES_PER_SECOND * 10)
+
 static Gameboy* gameboy = nullptr;
 
 static int fastForwardCounter;
 
+// Holds a frame of audio at up to 96 kHz, the highest rate any audio backend runs at.
 static u32 audioBuffer[2048];
+static u32 channelAudioBuffers[4][sizeof(audioBuffer) / sizeof(u32)];
 
-static std::chrono::time_point<std::chrono::high_resolution_clock> lastFrameTime;
+static std::chrono::time_point<std::chrono::high_resolution_clock> nextFrameTime;
+static bool vsyncEnabled;
+static bool framePresented;
 static std::chrono::time_point<std::chrono::system_clock> lastPrintTime;
 static int fps;
 static bool fastForward;
 
+static std::string romFilePath;
 static std::string romDir;
 static std::string romName;
 
-static u32 numPrinted;
-
 static int autoFireCounterA;
 static int autoFireCounterB;
 
 static bool emulationPaused;
 
+static bool savingDisabled;
+
+#ifdef GAMEBOY_MAPPED_SAVES
+static u8* mappedSave = nullptr;
+static u32 mappedSaveSize = 0;
+#endif
+
 static u8 optToConfigGroup[NUM_GB_OPT] = {
         GROUP_GAMEBOY,
         GROUP_GAMEBOY,
@@ -574,149 +619,244 @@ static std::string mgrGetStatePath(int stateNum) {
     return stream.str();
 }
 
-static std::string mgrGetPrintPath(bool& appending) {
-    // Find the first available "print number".
-    const std::string baseFile = mgrGetBasePath(GAMEYOB_PRINT_PATH);
-    while(true) {
-        std::stringstream finalStream;
-        finalStream << baseFile << "-" << numPrinted << ".bmp";
-
-        const std::string finalFile = finalStream.str();
-
-        // If appending, the last file written to is already selected.
-        // Else, if the file doesn't exist, we're done searching.
-        bool exists = access(finalFile.c_str(), R_OK) == 0;
-        if(appending || !exists) {
-            if(appending && !exists) {
-                // This is a failsafe, this shouldn't happen.
-                appending = false;
-                mgrPrintDebug("The image to be appended to doesn't exist: %s\n", finalFile.c_str());
-            }
+static std::string mgrGetMoviePath() {
+    return mgrGetBasePath(GAMEYOB_SAVE_STATE_PATH) + ".ymv";
+}
 
-            return finalFile;
-        }
+static std::string mgrGetCapturePath(const std::string& extension) {
+    return mgrGetBasePath(GAMEYOB_SAVE_STATE_PATH) + extension;
+}
 
-        numPrinted++;
-    }
+static u64 mgrGetTime() {
+    return (u64) time(nullptr);
 }
 
 static void mgrPrintImage(bool appending, u8* buf, int size, u8 palette) {
-    int width = PRINTER_WIDTH;
-
-    // In case of error, size must be rounded off to the nearest 16 vertical pixels.
-    if(size % (width / 4 * 16) != 0) {
-        size += (width / 4 * 16) - (size % (width / 4 * 16));
-    }
-
-    int height = size / width * 4;
-    int pixelArraySize = (width * height + 1) / 2;
-
-    u8 bmpHeader[] = { // Contains header data & palettes
-            0x42, 0x4d, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00, 0x28, 0x00,
-            0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x04, 0x00, 0x00, 0x00,
-            0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x12, 0x0b, 0x00, 0x00, 0x12, 0x0b, 0x00, 0x00, 0x04, 0x00,
-            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x55, 0x55, 0x55, 0x55, 0xaa, 0xaa,
-            0xaa, 0xaa, 0xff, 0xff, 0xff, 0xff
-    };
-
-    // Set up the palette
-    for(int i = 0; i < 4; i++) {
-        u8 rgb = 0;
-        switch((palette >> (i * 2)) & 3) {
-            case 0:
-                rgb = 0xff;
-                break;
-            case 1:
-                rgb = 0xaa;
-                break;
-            case 2:
-                rgb = 0x55;
-                break;
-            case 3:
-                rgb = 0x00;
-                break;
-            default:
+    if(!printoutBand(mgrGetBasePath(GAMEYOB_PRINT_PATH), appending, buf, size, palette)) {
+        mgrPrintDebug("Failed to open print file: %s\n", strerror(errno));
+    }
+}
+
+#ifdef GAMEBOY_MAPPED_ROMS
+static void mgrUnmapRom(u8* data, u32 size) {
+    munmap(data, size);
+}
+
+static Cartridge* mgrMapRom(const std::string& romFile, u32 romSize) {
+    // Only whole power-of-two dumps can be mapped as-is; anything else needs padding.
+    if(romSize < ROM_BANK_SIZE * 2 || (romSize & (romSize - 1)) != 0) {
+        return nullptr;
+    }
+
+    int fd = open(romFile.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    // Private and writable so the MMM01 fix-up can happen in place; untouched pages stay shared with the page cache.
+    void* block = mmap(nullptr, romSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(block == MAP_FAILED) {
+        mgrPrintDebug("Failed to map ROM file: %s\n", strerror(errno));
+        return nullptr;
+    }
+
+    RomFileId fileId = {(u64) st.st_dev, (u64) st.st_ino, (s64) st.st_mtime};
+
+    // The image store takes ownership of the mapping, or unmaps it right away if the ROM is already loaded.
+    return new Cartridge(RomImage::acquire((u8*) block, romSize, mgrUnmapRom, fileId));
+}
+#endif
+
+#ifdef GAMEBOY_LINK_CABLE
+// A second GameBoy running the same ROM on its own thread, linked to ours and played by the second player.
+static Gameboy* linkPartner = nullptr;
+static LinkCable* linkCable = nullptr;
+static std::thread linkPartnerThread;
+static std::atomic<u8> linkPartnerButtons(0xFF);
+
+// The partner parks between frames while we are paused, rather than waiting on us inside one.
+static std::mutex linkPartnerMutex;
+static std::condition_variable linkPartnerCond;
+static bool linkPartnerRunning = false;
+static bool linkPartnerPaused = false;
+
+// Taken when the partner starts, as the menu may change the configuration while it runs.
+static u8 linkPartnerOptions[NUM_GB_OPT];
+
+static void mgrSetLinkPartnerRumble(bool rumble) {
+}
+
+static u8 mgrGetLinkPartnerOption(GameboyOption opt) {
+    return linkPartnerOptions[opt];
+}
+
+static std::string mgrGetLinkPartnerSavePath() {
+    return mgrGetBasePath(GAMEYOB_SAVE_PATH) + ".link.sav";
+}
+
+static void mgrRunLinkPartner() {
+    // Otherwise paced by the cable, which never lets either side get more than a quantum ahead.
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(linkPartnerMutex);
+            linkPartnerCond.wait(lock, [] {
+                return !linkPartnerRunning || !linkPartnerPaused;
+            });
+
+            if(!linkPartnerRunning) {
                 break;
+            }
         }
 
-        for(int j = 0; j < 4; j++) {
-            bmpHeader[0x36 + i * 4 + j] = rgb;
+        linkPartner->sgb.setController(0, linkPartnerButtons.load(std::memory_order_relaxed));
+        linkPartner->runFrame();
+    }
+}
+
+static void mgrPauseLinkPartner(bool paused) {
+    if(linkPartner == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(linkPartnerMutex);
+        if(linkPartnerPaused == paused) {
+            return;
         }
+
+        linkPartnerPaused = paused;
     }
 
-    u16* pixelData = (u16*) malloc((size_t) pixelArraySize);
+    linkPartnerCond.notify_one();
+}
 
-    // Convert the gameboy's tile-based 2bpp into a linear 4bpp format.
-    for(int i = 0; i < size; i += 2) {
-        u8 b1 = buf[i];
-        u8 b2 = buf[i + 1];
+static void mgrStartLinkPartner() {
+    if(linkPartner != nullptr || gameboy == nullptr || gameboy->cartridge == nullptr || configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_LINK_CABLE) != LINK_CABLE_LOCAL) {
+        return;
+    }
 
-        int pixel = i * 4;
-        int tile = pixel / 64;
+    std::ifstream romStream(romFilePath, std::ios::binary | std::ios::ate);
+    if(!romStream.is_open()) {
+        mgrPrintDebug("Failed to open ROM file: %s\n", strerror(errno));
+        return;
+    }
 
-        int index = tile / 20 * width * 8;
-        index += (tile % 20) * 8;
-        index += ((pixel % 64) / 8) * width;
-        index += (pixel % 8);
-        index /= 4;
+    u32 romSize = (u32) romStream.tellg();
+    romStream.seekg(0);
 
-        pixelData[index] = 0;
-        pixelData[index + 1] = 0;
-        for(int j = 0; j < 2; j++) {
-            pixelData[index] |= (((b1 >> j >> 4) & 1) | (((b2 >> j >> 4) & 1) << 1)) << (j * 4 + 8);
-            pixelData[index] |= (((b1 >> j >> 6) & 1) | (((b2 >> j >> 6) & 1) << 1)) << (j * 4);
-            pixelData[index + 1] |= (((b1 >> j) & 1) | (((b2 >> j) & 1) << 1)) << (j * 4 + 8);
-            pixelData[index + 1] |= (((b1 >> j >> 2) & 1) | (((b2 >> j >> 2) & 1) << 1)) << (j * 4);
-        }
+    for(u32 opt = 0; opt < NUM_GB_OPT; opt++) {
+        linkPartnerOptions[opt] = configGetMultiChoice(optToConfigGroup[opt], optToConfigOption[opt]);
     }
 
-    const std::string path = mgrGetPrintPath(appending);
+    // The partner has no screen, and its serial port belongs to the cable.
+    linkPartnerOptions[GB_OPT_DRAW_ENABLED] = 0;
+    linkPartnerOptions[GB_OPT_PRINTER_ENABLED] = 0;
 
-    if(appending) {
-        std::fstream stream(path, std::fstream::in | std::fstream::out | std::fstream::binary | std::fstream::ate);
-        s64 end = stream.tellg();
+    linkPartner = new Gameboy();
 
-        int temp = 0;
+    linkPartner->settings.printDebug = nullptr;
 
-        // Update height
-        stream.seekg(0x16);
-        stream.read((char*) &temp, sizeof(temp));
-        temp = -(height + (-temp));
-        stream.seekg(0x16);
-        stream.write((char*) &temp, sizeof(temp));
+    linkPartner->settings.readTilt = nullptr;
+    linkPartner->settings.setRumble = mgrSetLinkPartnerRumble;
 
-        // Update pixelArraySize
-        stream.seekg(0x22);
-        stream.read((char*) &temp, sizeof(temp));
-        temp += pixelArraySize;
-        stream.seekg(0x22);
-        stream.write((char*) &temp, sizeof(temp));
+    linkPartner->settings.getTime = mgrGetTime;
 
-        // Update file size
-        temp += sizeof(bmpHeader);
-        stream.seekg(0x2);
-        stream.write((char*) &temp, sizeof(temp));
+    linkPartner->settings.getCameraImage = nullptr;
 
-        // Append pixel data
-        stream.seekg(end);
-        stream.write((char*) pixelData, pixelArraySize);
+    linkPartner->settings.printImage = nullptr;
 
-        stream.close();
-    } else { // Not appending; making a file from scratch
-        std::fstream stream(path, std::fstream::out | std::fstream::binary);
+    linkPartner->settings.getOption = mgrGetLinkPartnerOption;
 
-        *(u32*) (bmpHeader + 0x02) = sizeof(bmpHeader) + pixelArraySize;
-        *(u32*) (bmpHeader + 0x22) = (u32) pixelArraySize;
-        *(u32*) (bmpHeader + 0x12) = (u32) width;
-        *(u32*) (bmpHeader + 0x16) = (u32) -height;
+    linkPartner->settings.frameBuffer = nullptr;
+    linkPartner->settings.framePitch = 0;
 
-        stream.write((char*) bmpHeader, sizeof(bmpHeader));
-        stream.write((char*) pixelData, pixelArraySize);
-        stream.close();
+    linkPartner->settings.audioBuffer = nullptr;
+    linkPartner->settings.audioSamples = 0;
+    linkPartner->settings.audioSampleRate = audioGetSampleRate();
+
+    for(u32 i = 0; i < 4; i++) {
+        linkPartner->settings.channelAudioBuffers[i] = nullptr;
+    }
+
+    // Loaded the same way as ours, so it shares the ROM image already loaded for our side.
+    Cartridge* cartridge = nullptr;
+
+#ifdef GAMEBOY_MAPPED_ROMS
+    if(configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_MAPPED_ROMS) == MAPPED_ROMS_ON) {
+        cartridge = mgrMapRom(romFilePath, romSize);
+    }
+#endif
+
+    if(cartridge == nullptr) {
+        cartridge = new Cartridge(romStream, romSize);
+    }
+
+    linkPartner->insert(cartridge);
+    romStream.close();
+
+    // The partner keeps its own save, starting out as a copy of ours.
+    std::ifstream saveStream(mgrGetLinkPartnerSavePath(), std::ios::binary);
+    if(!saveStream.is_open()) {
+        saveStream.open(mgrGetBasePath(GAMEYOB_SAVE_PATH) + ".sav", std::ios::binary);
+    }
+
+    if(saveStream.is_open()) {
+        linkPartner->cartridge->load(saveStream);
+        saveStream.close();
+    }
+
+    linkPartner->powerOn();
+
+    linkCable = new LinkCable();
+    linkCable->connect(gameboy, linkPartner);
+
+    linkPartnerRunning = true;
+    linkPartnerPaused = false;
+    linkPartnerThread = std::thread(mgrRunLinkPartner);
+}
+
+static void mgrStopLinkPartner() {
+    if(linkPartner == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(linkPartnerMutex);
+        linkPartnerRunning = false;
+    }
+
+    // Disconnecting releases the partner if it is waiting on us inside a frame.
+    linkPartnerCond.notify_one();
+    linkCable->disconnect();
+    linkPartnerThread.join();
+
+    delete linkCable;
+    linkCable = nullptr;
+
+    std::ofstream saveStream(mgrGetLinkPartnerSavePath(), std::ios::binary);
+    if(saveStream.is_open()) {
+        linkPartner->cartridge->save(saveStream);
+        saveStream.close();
+    } else {
+        mgrPrintDebug("Failed to open link partner save file: %s\n", strerror(errno));
     }
 
-    free(pixelData);
+    Cartridge* cart = linkPartner->cartridge;
+    linkPartner->insert(nullptr);
+    delete cart;
+
+    delete linkPartner;
+    linkPartner = nullptr;
 }
+#endif
 
 void mgrInit() {
     gameboy = new Gameboy();
@@ -726,6 +866,8 @@ void mgrInit() {
     gameboy->settings.readTilt = inputGetMotionSensor;
     gameboy->settings.setRumble = inputSetRumble;
 
+    gameboy->settings.getTime = mgrGetTime;
+
     gameboy->settings.getCameraImage = systemGetCameraImage;
 
     gameboy->settings.printImage = mgrPrintImage;
@@ -739,15 +881,22 @@ void mgrInit() {
     gameboy->settings.audioSamples = sizeof(audioBuffer) / sizeof(u32);
     gameboy->settings.audioSampleRate = audioGetSampleRate();
 
+    for(u32 i = 0; i < 4; i++) {
+        gameboy->settings.channelAudioBuffers[i] = nullptr;
+    }
+
     fastForwardCounter = 0;
 
     memset(audioBuffer, 0, sizeof(audioBuffer));
 
-    lastFrameTime = std::chrono::high_resolution_clock::now();
+    nextFrameTime = std::chrono::high_resolution_clock::now();
+    vsyncEnabled = false;
+    framePresented = false;
     lastPrintTime = std::chrono::system_clock::now();
     fastForward = false;
     fps = 0;
 
+    romFilePath = "";
     romDir = "";
     romName = "";
 
@@ -756,12 +905,30 @@ void mgrInit() {
 
     emulationPaused = false;
 
+    savingDisabled = false;
+
     configLoad();
+    romIndexLoad();
+    dirScannerLoadCache();
+
+    mgrRefreshPacing();
+#ifdef SOUND_OUTPUT_RATE
+    mgrRefreshAudio();
+#endif
+    mgrRefreshCamera();
+    mgrRefreshLink();
 }
 
 void mgrExit() {
     mgrUnloadRom(true, true);
 
+    romIndexSave();
+    dirScannerSaveCache();
+
+#ifdef GAMEBOY_LINK_CABLE
+    netlinkStop();
+#endif
+
     if(gameboy != nullptr) {
         delete gameboy;
         gameboy = nullptr;
@@ -941,6 +1108,176 @@ void mgrRefreshBorder() {
     }
 }
 
+void mgrRefreshPacing() {
+#ifdef DISPLAY_FRAME_PACING
+    bool vsync = configGetMultiChoice(GROUP_DISPLAY, DISPLAY_FRAME_PACING) == FRAME_PACING_VSYNC;
+    vsyncEnabled = gfxSetVsync(vsync) && vsync;
+#endif
+}
+
+void mgrRefreshAudio() {
+    // The capture's WAV header is fixed to the rate it started at.
+    mgrStopCapture();
+
+    audioCleanup();
+    audioInit();
+
+    // The APU picks up the new rate at the end of its current frame.
+    if(gameboy != nullptr) {
+        gameboy->settings.audioSampleRate = audioGetSampleRate();
+    }
+}
+
+void mgrRefreshCamera() {
+#ifdef GAMEBOY_CAMERA_SOURCE
+    CameraSource source = CAMERA_SOURCE_OFF;
+    switch(configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_CAMERA_SOURCE)) {
+        case CAMERA_SOURCE_OPTION_IMAGE:
+            source = CAMERA_SOURCE_IMAGE;
+            break;
+        case CAMERA_SOURCE_OPTION_PATTERN:
+            source = CAMERA_SOURCE_PATTERN;
+            break;
+        default:
+            break;
+    }
+
+    if(!cameraSetSource(source, configGetPath(GROUP_GAMEBOY, GAMEBOY_CAMERA_IMAGE_PATH))) {
+        mgrPrintDebug("Failed to load camera image.\n");
+    }
+#endif
+}
+
+void mgrRefreshLink() {
+#ifdef GAMEBOY_LINK_CABLE
+    u8 mode = configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_LINK_CABLE);
+    if(mode != LINK_CABLE_LOCAL) {
+        mgrStopLinkPartner();
+    }
+
+    if(mode == LINK_CABLE_OFF || mode == LINK_CABLE_LOCAL) {
+        netlinkStop();
+        mgrStartLinkPartner();
+        return;
+    }
+
+    if(movieIsRecording() || movieIsPlaying()) {
+        mgrPrintDebug("Stopped the movie for the link cable.\n");
+        movieStop();
+    }
+
+    NetlinkTransport transport = configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_LINK_TRANSPORT) == LINK_TRANSPORT_TCP ? NETLINK_TRANSPORT_TCP : NETLINK_TRANSPORT_LOCAL;
+    if(!netlinkStart(gameboy, mode == LINK_CABLE_HOST, transport)) {
+        mgrPrintDebug("Failed to host link cable: %s\n", strerror(errno));
+    }
+#endif
+}
+
+static u8 mgrGetPlayerButtons(u32 player) {
+    u8 buttons = 0xFF;
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_UP)) {
+        buttons &= ~GB_UP;
+    }
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_DOWN)) {
+        buttons &= ~GB_DOWN;
+    }
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_LEFT)) {
+        buttons &= ~GB_LEFT;
+    }
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_RIGHT)) {
+        buttons &= ~GB_RIGHT;
+    }
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_A)) {
+        buttons &= ~GB_A;
+    }
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_B)) {
+        buttons &= ~GB_B;
+    }
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_START)) {
+        buttons &= ~GB_START;
+    }
+
+    if(inputPlayerKeyHeld(player, FUNC_KEY_SELECT)) {
+        buttons &= ~GB_SELECT;
+    }
+
+    return buttons;
+}
+
+static u8 mgrGetPacing() {
+#ifdef DISPLAY_FRAME_PACING
+    u8 pacing = configGetMultiChoice(GROUP_DISPLAY, DISPLAY_FRAME_PACING);
+    if(pacing == FRAME_PACING_AUDIO && configGetMultiChoice(GROUP_SOUND, SOUND_MASTER) != SOUND_ON) {
+        return FRAME_PACING_TIMER;
+    }
+
+    if(pacing == FRAME_PACING_VSYNC && !vsyncEnabled) {
+        return FRAME_PACING_TIMER;
+    }
+
+    return pacing;
+#else
+    return FRAME_PACING_TIMER;
+#endif
+}
+
+// Returns whether the next frame should run now. Where pacing is selectable this blocks
+// until it should, rather than leaving the caller to poll.
+static bool mgrWaitForFrame() {
+    auto now = std::chrono::high_resolution_clock::now();
+    bool running = gameboy->isPoweredOn() && !mgrIsPaused();
+
+    if(running && mgrGetFastForward()) {
+        nextFrameTime = now;
+        framePresented = false;
+        return true;
+    }
+
+#ifdef DISPLAY_FRAME_PACING
+    u8 pacing = mgrGetPacing();
+    if(pacing == FRAME_PACING_AUDIO && running && audioWaitForFrame()) {
+        nextFrameTime = std::chrono::high_resolution_clock::now() + std::chrono::nanoseconds(NS_PER_FRAME);
+        return true;
+    }
+
+    // Presenting the last frame already waited for vertical blank, unless it returned early
+    // (e.g. the window is hidden), in which case fall back to the timer.
+    bool presentWaited = nextFrameTime - now <= std::chrono::nanoseconds(NS_PER_FRAME / 2);
+    if(pacing == FRAME_PACING_VSYNC && framePresented && presentWaited) {
+        framePresented = false;
+        nextFrameTime = now + std::chrono::nanoseconds(NS_PER_FRAME);
+        return true;
+    }
+
+    s64 nsLeft = std::chrono::duration_cast<std::chrono::nanoseconds>(nextFrameTime - now).count();
+    if(nsLeft > NS_SLEEP_MARGIN) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nsLeft - NS_SLEEP_MARGIN));
+    }
+
+    while((now = std::chrono::high_resolution_clock::now()) < nextFrameTime) {
+    }
+#else
+    if(now < nextFrameTime) {
+        return false;
+    }
+#endif
+
+    // Advance by exactly one frame so that timer jitter doesn't accumulate into drift.
+    nextFrameTime += std::chrono::nanoseconds(NS_PER_FRAME);
+    if(now - nextFrameTime > std::chrono::nanoseconds(NS_PER_FRAME * MAX_FRAMES_BEHIND)) {
+        nextFrameTime = now + std::chrono::nanoseconds(NS_PER_FRAME);
+    }
+
+    return true;
+}
+
 bool mgrStateExists(int stateNum) {
     if(gameboy == nullptr || gameboy->cartridge == nullptr) {
         return false;
@@ -1041,12 +1378,71 @@ static void mgrSaveCheats() {
     }
 }
 
+#ifdef GAMEBOY_MAPPED_SAVES
+static void mgrMapSave() {
+    u32 size = gameboy->cartridge->getSramSize();
+    if(size == 0) {
+        return;
+    }
+
+    const std::string path = mgrGetBasePath(GAMEYOB_SAVE_PATH) + ".sav";
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0) {
+        mgrPrintDebug("Failed to open save file: %s\n", strerror(errno));
+        return;
+    }
+
+    // Grow short or new files to cover SRAM; any RTC trailer past that is left alone.
+    struct stat st;
+    if(fstat(fd, &st) < 0 || (st.st_size < size && ftruncate(fd, size) < 0)) {
+        mgrPrintDebug("Failed to size save file: %s\n", strerror(errno));
+
+        close(fd);
+        return;
+    }
+
+    void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(block == MAP_FAILED) {
+        mgrPrintDebug("Failed to map save file: %s\n", strerror(errno));
+        return;
+    }
+
+    mappedSave = (u8*) block;
+    mappedSaveSize = size;
+
+    gameboy->cartridge->setSramBuffer(mappedSave);
+}
+
+static void mgrUnmapSave() {
+    if(mappedSave != nullptr) {
+        munmap(mappedSave, mappedSaveSize);
+
+        mappedSave = nullptr;
+        mappedSaveSize = 0;
+    }
+}
+#endif
+
 static void mgrWriteSave() {
-    if(gameboy == nullptr || gameboy->cartridge == nullptr) {
+    if(gameboy == nullptr || gameboy->cartridge == nullptr || savingDisabled) {
         return;
     }
 
-    std::ofstream stream(mgrGetBasePath(GAMEYOB_SAVE_PATH) + ".sav", std::ios::binary);
+    std::ios::openmode mode = std::ios::out | std::ios::binary;
+
+#ifdef GAMEBOY_MAPPED_SAVES
+    if(mappedSave != nullptr) {
+        msync(mappedSave, mappedSaveSize, MS_SYNC);
+
+        // SRAM is already in the file; don't truncate it out from under the mapping.
+        mode |= std::ios::in;
+    }
+#endif
+
+    std::fstream stream(mgrGetBasePath(GAMEYOB_SAVE_PATH) + ".sav", mode);
     if(!stream.is_open()) {
         mgrPrintDebug("Failed to open save file: %s\n", strerror(errno));
         return;
@@ -1056,11 +1452,48 @@ static void mgrWriteSave() {
     stream.close();
 }
 
+static void mgrFlushSave() {
+    if(gameboy == nullptr || gameboy->cartridge == nullptr || !gameboy->cartridge->isSramDirty() || savingDisabled) {
+        return;
+    }
+
+    std::fstream stream(mgrGetBasePath(GAMEYOB_SAVE_PATH) + ".sav", std::fstream::in | std::fstream::out | std::fstream::binary);
+    if(!stream.is_open()) {
+        // No save file yet, write out the whole thing.
+        mgrWriteSave();
+        return;
+    }
+
+#ifdef GAMEBOY_MAPPED_SAVES
+    if(mappedSave != nullptr) {
+        msync(mappedSave, mappedSaveSize, MS_ASYNC);
+    }
+#endif
+
+    gameboy->cartridge->saveDirty(stream);
+    stream.close();
+}
+
+static void mgrAutoSave() {
+    if(gameboy->cartridge == nullptr || !gameboy->cartridge->isSramDirty() || configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_AUTO_SAVE) != AUTO_SAVE_ON) {
+        return;
+    }
+
+    u64 cycle = gameboy->cpu.getCycle();
+    if(cycle - gameboy->cartridge->getSramWriteCycle() >= AUTO_SAVE_IDLE_CYCLES || cycle - gameboy->cartridge->getSramDirtyCycle() >= AUTO_SAVE_MAX_CYCLES) {
+        mgrFlushSave();
+    }
+}
+
 static void mgrRefreshState() {
     mgrRefreshBorder();
     mgrRefreshPalette();
 
     memset(gfxGetScreenBuffer(), 0, gfxGetScreenPitch() * GB_FRAME_HEIGHT * sizeof(u32));
+    if(gameboy != nullptr && gameboy->isPoweredOn()) {
+        gameboy->sgb.invalidateBorder();
+    }
+
     gfxDrawScreen();
 }
 
@@ -1069,8 +1502,14 @@ static void mgrLoadRom(const std::string& romFile) {
         return;
     }
 
+#ifdef GAMEBOY_LINK_CABLE
+    mgrStopLinkPartner();
+#endif
+
     gameboy->powerOff();
 
+    savingDisabled = false;
+
     if(!romFile.empty()) {
         std::ifstream romStream(romFile, std::ios::binary | std::ios::ate);
         if(!romStream.is_open()) {
@@ -1081,6 +1520,9 @@ static void mgrLoadRom(const std::string& romFile) {
         u32 romSize = (u32) romStream.tellg();
         romStream.seekg(0);
 
+        romFilePath = romFile;
+        romIndexQueue(romFilePath);
+
         std::string::size_type dot = romFile.find_last_of('.');
         if(dot != std::string::npos) {
             romName = romFile.substr(0, dot);
@@ -1096,10 +1538,28 @@ static void mgrLoadRom(const std::string& romFile) {
             romDir = "/";
         }
 
-        gameboy->insert(new Cartridge(romStream, romSize));
+        Cartridge* cartridge = nullptr;
+
+#ifdef GAMEBOY_MAPPED_ROMS
+        if(configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_MAPPED_ROMS) == MAPPED_ROMS_ON) {
+            cartridge = mgrMapRom(romFile, romSize);
+        }
+#endif
+
+        if(cartridge == nullptr) {
+            cartridge = new Cartridge(romStream, romSize);
+        }
+
+        gameboy->insert(cartridge);
 
         romStream.close();
 
+#ifdef GAMEBOY_MAPPED_SAVES
+        if(configGetMultiChoice(GROUP_GAMEBOY, GAMEBOY_MAPPED_SAVES) == MAPPED_SAVES_ON) {
+            mgrMapSave();
+        }
+#endif
+
         std::ifstream saveStream(mgrGetBasePath(GAMEYOB_SAVE_PATH) + ".sav", std::ios::binary);
         if(saveStream.is_open()) {
             gameboy->cartridge->load(saveStream);
@@ -1120,6 +1580,10 @@ static void mgrLoadRom(const std::string& romFile) {
         mgrLoadState(-1);
         mgrDeleteState(-1);
     }
+
+#ifdef GAMEBOY_LINK_CABLE
+    mgrStartLinkPartner();
+#endif
 }
 
 void mgrUnloadRom(bool save, bool exiting) {
@@ -1127,6 +1591,14 @@ void mgrUnloadRom(bool save, bool exiting) {
         return;
     }
 
+    mgrStopCapture();
+    movieStop();
+    printoutStop();
+#ifdef GAMEBOY_LINK_CABLE
+    mgrStopLinkPartner();
+    netlinkResync();
+#endif
+
     gameboy->powerOff();
 
     if(gameboy->cartridge != nullptr) {
@@ -1134,13 +1606,22 @@ void mgrUnloadRom(bool save, bool exiting) {
             mgrWriteSave();
         }
 
+        if(!romFilePath.empty()) {
+            romIndexSetThumbnail(romFilePath, gfxGetScreenBuffer(), gfxGetScreenPitch());
+        }
+
         mgrSaveCheats();
 
         Cartridge* cart = gameboy->cartridge;
         gameboy->insert(nullptr);
         delete cart;
+
+#ifdef GAMEBOY_MAPPED_SAVES
+        mgrUnmapSave();
+#endif
     }
 
+    romFilePath = "";
     romDir = "";
     romName = "";
 
@@ -1154,13 +1635,154 @@ void mgrReset() {
         return;
     }
 
+    movieStop();
+#ifdef GAMEBOY_LINK_CABLE
+    netlinkResync();
+#endif
+
     gameboy->powerOff();
     gameboy->powerOn();
 
     mgrRefreshState();
 }
 
+bool mgrMovieExists() {
+    if(gameboy == nullptr || gameboy->cartridge == nullptr) {
+        return false;
+    }
+
+    std::ifstream stream(mgrGetMoviePath(), std::ios::binary);
+    if(stream.is_open()) {
+        stream.close();
+        return true;
+    }
+
+    return false;
+}
+
+#ifdef GAMEBOY_LINK_CABLE
+// Rollbacks replay frames under the movie's hooks, and link bytes aren't recorded, so the two don't mix.
+static bool mgrCheckMovieLink() {
+    if(netlinkIsStarted()) {
+        mgrPrintDebug("Movies can't be used while the link cable is on.\n");
+        return false;
+    }
+
+    netlinkResync();
+    return true;
+}
+#endif
+
+bool mgrRecordMovie(bool powerOn) {
+    if(gameboy == nullptr || gameboy->cartridge == nullptr) {
+        return false;
+    }
+
+#ifdef GAMEBOY_LINK_CABLE
+    if(!mgrCheckMovieLink()) {
+        return false;
+    }
+#endif
+
+    if(!movieRecord(gameboy, mgrGetMoviePath(), powerOn)) {
+        mgrPrintDebug("Failed to record movie: %s\n", strerror(errno));
+        return false;
+    }
+
+    if(powerOn) {
+        mgrRefreshState();
+    }
+
+    return true;
+}
+
+bool mgrPlayMovie() {
+    if(gameboy == nullptr || gameboy->cartridge == nullptr) {
+        return false;
+    }
+
+#ifdef GAMEBOY_LINK_CABLE
+    if(!mgrCheckMovieLink()) {
+        return false;
+    }
+#endif
+
+#ifdef GAMEBOY_MAPPED_SAVES
+    // Playback replaces SRAM, so keep it away from the save file.
+    if(mappedSave != nullptr) {
+        gameboy->cartridge->setSramBuffer(nullptr);
+        mgrUnmapSave();
+    }
+#endif
+
+    if(!moviePlay(gameboy, mgrGetMoviePath())) {
+        mgrPrintDebug("Failed to play movie.\n");
+        return false;
+    }
+
+    // SRAM now comes from the movie; don't let it overwrite the real save until the ROM is reloaded.
+    savingDisabled = true;
+
+    mgrRefreshState();
+    return true;
+}
+
+void mgrStopMovie() {
+    movieStop();
+}
+
+bool mgrStartCapture() {
+    if(gameboy == nullptr || gameboy->cartridge == nullptr) {
+        return false;
+    }
+
+    std::vector<std::string> audioPaths = {mgrGetCapturePath(".wav")};
+
+    // Per-channel stems come from the same run as the mix, so they line up with it sample for sample.
+    bool stems = configGetMultiChoice(GROUP_SOUND, SOUND_CAPTURE_CHANNELS) == SOUND_ON;
+    if(stems) {
+        for(u32 i = 0; i < 4; i++) {
+            audioPaths.push_back(mgrGetCapturePath(".ch" + std::to_string(i + 1) + ".wav"));
+        }
+    }
+
+    if(!captureStart(mgrGetCapturePath(".y4m"), audioPaths, gameboy->settings.audioSampleRate)) {
+        mgrPrintDebug("Failed to start capture: %s\n", strerror(errno));
+        return false;
+    }
+
+    if(stems) {
+        // The APU switches over at the end of its current frame; until then the stems are silent.
+        memset(channelAudioBuffers, 0, sizeof(channelAudioBuffers));
+
+        for(u32 i = 0; i < 4; i++) {
+            gameboy->settings.channelAudioBuffers[i] = channelAudioBuffers[i];
+        }
+    }
+
+    return true;
+}
+
+void mgrStopCapture() {
+    if(!captureIsRecording()) {
+        return;
+    }
+
+    captureStop();
+
+    for(u32 i = 0; i < 4; i++) {
+        gameboy->settings.channelAudioBuffers[i] = nullptr;
+    }
+
+    u32 dropped = captureGetDroppedFrames();
+    if(dropped > 0) {
+        mgrPrintDebug("Capture dropped %u frames.\n", dropped);
+    }
+}
+
 void mgrRun() {
+    bool frameDue = mgrWaitForFrame();
+
     inputUpdate();
 
     if(!gameboy->isPoweredOn() && !menuIsVisible()) {
@@ -1211,49 +1833,22 @@ void mgrRun() {
             menuOpenMain();
         }
 
-        auto frameTime = std::chrono::high_resolution_clock::now();
-        s64 nsPassed = std::chrono::duration_cast<std::chrono::nanoseconds>(frameTime - lastFrameTime).count();
-        if(!mgrIsPaused() && (mgrGetFastForward() || nsPassed >= NS_PER_FRAME)) {
-            lastFrameTime = frameTime;
+#ifdef GAMEBOY_LINK_CABLE
+        mgrPauseLinkPartner(mgrIsPaused());
+#endif
 
-            u8 buttonsPressed = 0xFF;
+        if(!mgrIsPaused() && frameDue) {
+            u8 buttonsPressed[SGB_MAX_CONTROLLERS];
+            memset(buttonsPressed, 0xFF, sizeof(buttonsPressed));
 
             if(!menuIsVisible()) {
-                if(inputKeyHeld(FUNC_KEY_UP)) {
-                    buttonsPressed &= ~GB_UP;
-                }
-
-                if(inputKeyHeld(FUNC_KEY_DOWN)) {
-                    buttonsPressed &= ~GB_DOWN;
-                }
-
-                if(inputKeyHeld(FUNC_KEY_LEFT)) {
-                    buttonsPressed &= ~GB_LEFT;
-                }
-
-                if(inputKeyHeld(FUNC_KEY_RIGHT)) {
-                    buttonsPressed &= ~GB_RIGHT;
-                }
-
-                if(inputKeyHeld(FUNC_KEY_A)) {
-                    buttonsPressed &= ~GB_A;
-                }
-
-                if(inputKeyHeld(FUNC_KEY_B)) {
-                    buttonsPressed &= ~GB_B;
-                }
-
-                if(inputKeyHeld(FUNC_KEY_START)) {
-                    buttonsPressed &= ~GB_START;
-                }
-
-                if(inputKeyHeld(FUNC_KEY_SELECT)) {
-                    buttonsPressed &= ~GB_SELECT;
+                for(u32 player = 0; player < SGB_MAX_CONTROLLERS && player < INPUT_MAX_PLAYERS; player++) {
+                    buttonsPressed[player] = mgrGetPlayerButtons(player);
                 }
 
                 if(inputKeyHeld(FUNC_KEY_AUTO_A)) {
                     if(autoFireCounterA <= 0) {
-                        buttonsPressed &= ~GB_A;
+                        buttonsPressed[0] &= ~GB_A;
                         autoFireCounterA = 2;
                     }
 
@@ -1262,7 +1857,7 @@ void mgrRun() {
 
                 if(inputKeyHeld(FUNC_KEY_AUTO_B)) {
                     if(autoFireCounterB <= 0) {
-                        buttonsPressed &= ~GB_B;
+                        buttonsPressed[0] &= ~GB_B;
                         autoFireCounterB = 2;
                     }
 
@@ -1270,9 +1865,37 @@ void mgrRun() {
                 }
             }
 
-            gameboy->sgb.setController(0, buttonsPressed);
+#ifdef GAMEBOY_LINK_CABLE
+            if(linkPartner != nullptr) {
+                // The second player's controls go to the linked GameBoy instead.
+                linkPartnerButtons.store(buttonsPressed[1], std::memory_order_relaxed);
+                buttonsPressed[1] = 0xFF;
+            }
+#endif
+
+            movieUpdate(buttonsPressed);
+
+            // When the audio device paces us, it is by definition running at the emulated rate.
+            gameboy->apu.setRateScale(mgrGetPacing() == FRAME_PACING_AUDIO ? 1 : audioGetRateScale());
+            for(u8 controller = 0; controller < SGB_MAX_CONTROLLERS; controller++) {
+                gameboy->sgb.setController(controller, buttonsPressed[controller]);
+            }
+
+#ifdef GAMEBOY_LINK_CABLE
+            netlinkBeginFrame(buttonsPressed);
+#endif
+
             gameboy->runFrame();
 
+#ifdef GAMEBOY_LINK_CABLE
+            netlinkEndFrame();
+#endif
+
+            const u32* captureAudio[] = {audioBuffer, channelAudioBuffers[0], channelAudioBuffers[1], channelAudioBuffers[2], channelAudioBuffers[3]};
+            captureFrame(gameboy->settings.frameBuffer, gameboy->settings.framePitch, captureAudio, gameboy->audioSamplesWritten);
+
+            mgrAutoSave();
+
             if(configGetMultiChoice(GROUP_SOUND, SOUND_MASTER) == SOUND_ON) {
                 audioPlay(audioBuffer, gameboy->audioSamplesWritten);
             }
@@ -1280,6 +1903,8 @@ void mgrRun() {
             if(!mgrGetFastForward() || fastForwardCounter++ >= configGetMultiChoice(GROUP_DISPLAY, DISPLAY_FF_FRAME_SKIP)) {
                 fastForwardCounter = 0;
                 gfxDrawScreen();
+
+                framePresented = vsyncEnabled;
             }
 
 #ifndef BACKEND_SWITCH
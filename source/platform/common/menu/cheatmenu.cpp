@@ -1,6 +1,7 @@
 #include <sstream>
 
 #include "platform/common/menu/cheatmenu.h"
+#include "platform/common/menu/cheatsearchmenu.h"
 #include "platform/common/menu/menu.h"
 #include "platform/common/manager.h"
 #include "platform/ui.h"
@@ -58,16 +59,15 @@ bool CheatsMenu::processInput(UIKey key, u32 width, u32 height) {
 
             return true;
         }
+    } else if(key == UI_KEY_Y) {
+        menuPush(new CheatSearchMenu());
     }
 
     return false;
 }
 
 void CheatsMenu::draw(u32 width, u32 height) {
-    cheatsPerPage = height - 2;
-    if(uiIsStringInputSupported()) {
-        cheatsPerPage--;
-    }
+    cheatsPerPage = height - 3;
 
     CheatEngine* cheatEngine = &mgrGetGameboy()->cheatEngine;
 
@@ -132,8 +132,10 @@ void CheatsMenu::draw(u32 width, u32 height) {
         }
     }
 
+    uiSetLine(height - 1);
     if(uiIsStringInputSupported()) {
-        uiSetLine(height - 1);
-        uiPrint("Press X to add a cheat.");
+        uiPrint("X: Add cheat, Y: Search memory");
+    } else {
+        uiPrint("Press Y to search memory.");
     }
 }
\ No newline at end of file
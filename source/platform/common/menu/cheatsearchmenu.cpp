@@ -0,0 +1,167 @@
+#include <sstream>
+
+#include "platform/common/menu/cheatsearchmenu.h"
+#include "platform/common/menu/menu.h"
+#include "platform/common/manager.h"
+#include "platform/ui.h"
+#include "cheatengine.h"
+#include "gameboy.h"
+
+#define SEARCH_OPTION_RELATION 0
+#define SEARCH_OPTION_VALUE 1
+#define SEARCH_OPTION_NEW 2
+#define SEARCH_OPTION_FILTER 3
+
+#define SEARCH_OPTION_COUNT 4
+
+// Title, blank line, options, blank line and message line.
+#define SEARCH_MENU_RESERVED_LINES (SEARCH_OPTION_COUNT + 4)
+
+void CheatSearchMenu::addCandidateCheat(u32 index) {
+    Gameboy* gameboy = mgrGetGameboy();
+    CheatSearch* search = &gameboy->cheatSearch;
+
+    u32 position = search->getCandidate(index);
+
+    std::stringstream nameStream;
+    nameStream << "Search " << std::hex << std::uppercase << search->getAddress(position);
+
+    gameboy->cheatEngine.addCheat(nameStream.str(), search->getCode(position, this->value));
+    gameboy->cheatEngine.toggleCheat(gameboy->cheatEngine.getNumCheats() - 1, true);
+
+    this->message = "Added " + search->getCode(position, this->value) + ".";
+}
+
+bool CheatSearchMenu::processInput(UIKey key, u32 width, u32 height) {
+    CheatSearch* search = &mgrGetGameboy()->cheatSearch;
+    u32 numItems = SEARCH_OPTION_COUNT + search->getNumCandidates();
+
+    if(key == UI_KEY_B) {
+        menuPop();
+    } else if(key == UI_KEY_UP) {
+        this->selection = this->selection > 0 ? this->selection - 1 : numItems - 1;
+        return true;
+    } else if(key == UI_KEY_DOWN) {
+        this->selection = this->selection < numItems - 1 ? this->selection + 1 : 0;
+        return true;
+    } else if(key == UI_KEY_LEFT || key == UI_KEY_RIGHT) {
+        int dir = key == UI_KEY_LEFT ? -1 : 1;
+
+        if(this->selection == SEARCH_OPTION_RELATION) {
+            this->relation = (SearchRelation) ((this->relation + NUM_SEARCH_RELATIONS + dir) % NUM_SEARCH_RELATIONS);
+            return true;
+        } else if(this->selection == SEARCH_OPTION_VALUE) {
+            this->value = (u8) (this->value + dir);
+            return true;
+        }
+    } else if(key == UI_KEY_L || key == UI_KEY_R) {
+        int dir = key == UI_KEY_L ? -1 : 1;
+
+        if(this->selection == SEARCH_OPTION_VALUE) {
+            this->value = (u8) (this->value + dir * 0x10);
+            return true;
+        }
+    } else if(key == UI_KEY_A) {
+        this->message = "";
+
+        if(this->selection == SEARCH_OPTION_NEW) {
+            search->start();
+            if(!search->isActive()) {
+                this->message = "No ROM loaded.";
+            }
+        } else if(this->selection == SEARCH_OPTION_FILTER) {
+            if(search->isActive()) {
+                search->filter(this->relation, this->value);
+            } else {
+                this->message = "Start a new search first.";
+            }
+        } else if(this->selection >= SEARCH_OPTION_COUNT) {
+            this->addCandidateCheat(this->selection - SEARCH_OPTION_COUNT);
+        }
+
+        if(this->selection >= SEARCH_OPTION_COUNT + search->getNumCandidates()) {
+            this->selection = SEARCH_OPTION_FILTER;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void CheatSearchMenu::draw(u32 width, u32 height) {
+    CheatSearch* search = &mgrGetGameboy()->cheatSearch;
+
+    std::stringstream titleStream;
+    titleStream << "Memory Search - " << search->getNumCandidates() << " found";
+    const std::string title = titleStream.str();
+
+    uiAdvanceCursor((width - 1 - title.length()) / 2);
+    uiPrint("%s\n\n", title.c_str());
+
+    for(u32 i = 0; i < SEARCH_OPTION_COUNT; i++) {
+        if(this->selection == i) {
+            uiSetLineHighlighted(true);
+            uiSetTextColor(TEXT_COLOR_YELLOW);
+        }
+
+        switch(i) {
+            case SEARCH_OPTION_RELATION:
+                uiPrint("Compare: %s\n", CheatSearch::getRelationName(this->relation).c_str());
+                break;
+            case SEARCH_OPTION_VALUE:
+                uiPrint("Value: %u (0x%02X)\n", this->value, this->value);
+                break;
+            case SEARCH_OPTION_NEW:
+                uiPrint("New Search\n");
+                break;
+            case SEARCH_OPTION_FILTER:
+                uiPrint("Filter\n");
+                break;
+            default:
+                break;
+        }
+
+        if(this->selection == i) {
+            uiSetTextColor(TEXT_COLOR_NONE);
+            uiSetLineHighlighted(false);
+        }
+    }
+
+    uiPrint("\n");
+
+    u32 listLines = height > SEARCH_MENU_RESERVED_LINES ? height - SEARCH_MENU_RESERVED_LINES : 1;
+    if(this->selection >= SEARCH_OPTION_COUNT) {
+        u32 index = this->selection - SEARCH_OPTION_COUNT;
+        if(index < this->scrollY) {
+            this->scrollY = index;
+        } else if(index >= this->scrollY + listLines) {
+            this->scrollY = index - listLines + 1;
+        }
+    }
+
+    for(u32 i = this->scrollY; i < search->getNumCandidates() && i < this->scrollY + listLines; i++) {
+        u32 position = search->getCandidate(i);
+
+        bool selected = this->selection == SEARCH_OPTION_COUNT + i;
+        if(selected) {
+            uiSetLineHighlighted(true);
+            uiSetTextColor(TEXT_COLOR_YELLOW);
+        }
+
+        u8 candidateValue = search->getValue(position);
+        uiPrint("%02X:%04X = %u (0x%02X)\n", search->getBank(position), search->getAddress(position), candidateValue, candidateValue);
+
+        if(selected) {
+            uiSetTextColor(TEXT_COLOR_NONE);
+            uiSetLineHighlighted(false);
+        }
+    }
+
+    uiSetLine(height - 1);
+    if(!this->message.empty()) {
+        uiPrint("%s", this->message.c_str());
+    } else if(this->selection >= SEARCH_OPTION_COUNT) {
+        uiPrint("Press A to keep this at Value.");
+    }
+}
@@ -2,7 +2,7 @@
 
 #include <algorithm>
 #include <cstring>
-#include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -10,6 +10,7 @@
 #include "platform/common/menu/filechooser.h"
 #include "platform/common/config.h"
 #include "platform/common/manager.h"
+#include "platform/common/romindex.h"
 #include "platform/input.h"
 #include "platform/system.h"
 #include "platform/ui.h"
@@ -19,12 +20,18 @@
 #define FLAG_ROM        4
 #define FLAG_SPECIAL    8
 
+static bool isRomExtension(const std::string& extension) {
+    return extension == "cgb" || extension == "gbc" || extension == "gb" || extension == "sgb";
+}
+
 FileChooser::FileChooser(std::function<void(bool, const std::string&)> finished, const std::string& directory, const std::vector<std::string>& extensions, bool canClear) {
     this->finished = finished;
     this->directory = directory;
     this->extensions = extensions;
     this->canClear = canClear;
 
+    this->showRomInfo = std::find_if(extensions.begin(), extensions.end(), isRomExtension) != extensions.end();
+
     // If the path is to a file, open the parent directory.
     DIR* dir = nullptr;
     while((dir = opendir(this->directory.c_str())) == nullptr) {
@@ -50,6 +57,10 @@ FileChooser::FileChooser(std::function<void(bool, const std::string&)> finished,
 
 bool FileChooser::processInput(UIKey key, u32 width, u32 height) {
     if(key == UI_KEY_A) {
+        if(selection >= files.size()) {
+            return false;
+        }
+
         FileEntry& entry = files[selection];
 
         if(entry.flags & FLAG_DIRECTORY) {
@@ -99,19 +110,26 @@ bool FileChooser::processInput(UIKey key, u32 width, u32 height) {
     } else if(key == UI_KEY_UP) {
         if(selection > 0) {
             selection--;
+            selectionMoved = true;
             updateScrollUp();
 
             return true;
         }
     } else if(key == UI_KEY_DOWN) {
-        if(selection < files.size() - 1) {
+        if(selection + 1 < files.size()) {
             selection++;
+            selectionMoved = true;
             updateScrollDown();
 
             return true;
         }
     } else if(key == UI_KEY_RIGHT) {
+        if(files.empty()) {
+            return false;
+        }
+
         selection += filesPerPage / 2;
+        selectionMoved = true;
         if(selection >= files.size()) {
             selection = files.size() - 1;
         }
@@ -126,6 +144,7 @@ bool FileChooser::processInput(UIKey key, u32 width, u32 height) {
             selection = 0;
         }
 
+        selectionMoved = true;
         updateScrollUp();
 
         return true;
@@ -140,6 +159,10 @@ void FileChooser::draw(u32 width, u32 height) {
         filesPerPage--;
     }
 
+    if(showRomInfo) {
+        filesPerPage--;
+    }
+
     std::string currDirName;
     if(currDirName.length() > width) {
         currDirName = directory.substr(0, width);
@@ -196,12 +219,101 @@ void FileChooser::draw(u32 width, u32 height) {
         }
     }
 
+    romInfoPending = false;
+
+    if(showRomInfo && selection < files.size() && (files[selection].flags & FLAG_ROM)) {
+        RomIndexEntry info;
+        if(romIndexLookup(directory + files[selection].name, &info)) {
+            std::stringstream stream;
+            stream << "\"" << info.title << "\" " << (info.cgbFlag == 0xC0 ? "CGB" : info.cgbFlag == 0x80 ? "CGB/DMG" : "DMG");
+            if(info.sgbFlag == 0x03) {
+                stream << "+SGB";
+            }
+
+            stream << " MBC:" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << (u32) info.rawMBC;
+            stream << " CRC:" << std::setw(8) << info.crc32;
+
+            std::string line = stream.str();
+            if(line.length() > width) {
+                line = line.substr(0, width);
+            }
+
+            uiSetLine(height - (canClear ? 2 : 1));
+            uiPrint("%s", line.c_str());
+        } else {
+            romInfoPending = true;
+        }
+    }
+
     if(canClear) {
         uiSetLine(height - 1);
         uiPrint("Press X to clear the current setting.");
     }
 }
 
+bool FileChooser::update() {
+    // Only redraw for the index when the selected ROM was still waiting on it.
+    bool redraw = false;
+    if(romInfoPending) {
+        u32 version = romIndexGetVersion();
+        if(version != romIndexVersion) {
+            romIndexVersion = version;
+            redraw = true;
+        }
+    }
+
+    if(!scanning) {
+        return redraw;
+    }
+
+    std::vector<DirScanEntry> entries;
+    bool done = scanner.poll(entries);
+    if(entries.empty() && !done) {
+        return redraw;
+    }
+
+    // Once the user has moved the cursor, keep it on the same entry as new ones stream in.
+    std::string selected;
+    if(selectionMoved && selection < files.size()) {
+        selected = files[selection].name;
+    }
+
+    addEntries(entries);
+
+    std::sort(files.begin(), files.end(), compareFiles);
+
+    if(!initialSelection.empty()) {
+        selected = initialSelection;
+    }
+
+    if(!selected.empty()) {
+        for(u32 i = 0; i < files.size(); i++) {
+            if(selected == files[i].name) {
+                selection = i;
+                initialSelection = "";
+                break;
+            }
+        }
+    }
+
+    if(done) {
+        scanning = false;
+        initialSelection = "";
+
+        if(selection >= files.size()) {
+            selection = 0;
+        }
+    }
+
+    if(selection < scrollY) {
+        updateScrollUp();
+    } else {
+        updateScrollDown();
+    }
+
+    return true;
+}
+
 void FileChooser::updateScrollDown() {
     if(filesPerPage < files.size()) {
         if(selection == files.size() - 1) {
@@ -253,6 +365,7 @@ bool FileChooser::compareFiles(FileEntry &a, FileEntry &b) {
 
 void FileChooser::refreshContents() {
     files.clear();
+    states.clear();
 
     if(directory != "/") {
         files.push_back({"..", FLAG_SPECIAL | FLAG_DIRECTORY});
@@ -262,82 +375,84 @@ void FileChooser::refreshContents() {
         files.push_back({"<use this directory>", FLAG_SPECIAL});
     }
 
-    DIR* dir = opendir(directory.c_str());
-    if(dir != nullptr) {
-        // Read file list
-        dirent* entry;
-        while((entry = readdir(dir)) != nullptr) {
-            std::string fullName = entry->d_name;
+    // Save states are found with one pass over their directory rather than a lookup per ROM.
+    // That directory is listed first, so ROMs are usually flagged as suspended as soon as they appear.
+    std::vector<std::string> directories;
 
-            if(fullName == "." || fullName == "..") {
-                continue;
-            }
+    std::string stateDirectory = configGetPath(GROUP_GAMEYOB, GAMEYOB_SAVE_STATE_PATH);
+    if(!stateDirectory.empty() && stateDirectory[stateDirectory.length() - 1] != '/') {
+        stateDirectory += '/';
+    }
 
-            std::string name;
-            std::string extension;
+    if(!stateDirectory.empty() && stateDirectory != directory) {
+        directories.push_back(stateDirectory);
+    }
 
-            std::string::size_type dotPos = fullName.rfind('.');
-            if(dotPos != std::string::npos) {
-                name = fullName.substr(0, dotPos);
-                extension = fullName.substr(dotPos + 1);
-            } else {
-                name = fullName;
-            }
+    stateSource = 0;
+    contentsSource = (u32) directories.size();
 
-            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    directories.push_back(directory);
 
-            if((entry->d_type & DT_DIR) || std::find(extensions.begin(), extensions.end(), extension) != extensions.end()) {
-                u8 flags = 0;
+    scanner.start(directories);
+    scanning = true;
+    selectionMoved = false;
 
-                if(entry->d_type & DT_DIR) {
-                    flags |= FLAG_DIRECTORY;
-                } else if(extension == "cgb" || extension == "gbc" || extension == "gb" || extension == "sgb") {
-                    flags |= FLAG_ROM;
+    scrollY = 0;
+}
 
-                    std::stringstream stateStream;
+void FileChooser::addEntries(const std::vector<DirScanEntry>& entries) {
+    bool newStates = false;
 
-                    const std::string basePath = configGetPath(GROUP_GAMEYOB, GAMEYOB_SAVE_STATE_PATH);
-                    if(!basePath.empty()) {
-                        stateStream << basePath << "/";
-                    } else {
-                        stateStream << directory;
-                    }
+    for(const DirScanEntry& entry : entries) {
+        const std::string& fullName = entry.name;
 
-                    stateStream << name << ".yss";
+        std::string name;
+        std::string extension;
 
-                    const std::string stateFile = stateStream.str();
-                    std::ifstream stream(stateFile, std::ios::binary);
-                    if(stream.is_open()) {
-                        stream.close();
+        std::string::size_type dotPos = fullName.rfind('.');
+        if(dotPos != std::string::npos) {
+            name = fullName.substr(0, dotPos);
+            extension = fullName.substr(dotPos + 1);
+        } else {
+            name = fullName;
+        }
 
-                        flags |= FLAG_SUSPENDED;
-                    }
-                }
+        if(entry.directory == stateSource && !entry.isDirectory && extension == "yss") {
+            states.insert(name);
+            newStates = true;
+        }
 
-                files.push_back({fullName, flags});
-            }
+        if(entry.directory != contentsSource) {
+            continue;
         }
 
-        closedir(dir);
-    }
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
 
-    std::sort(files.begin(), files.end(), compareFiles);
+        if(entry.isDirectory || std::find(extensions.begin(), extensions.end(), extension) != extensions.end()) {
+            u8 flags = 0;
 
-    if(selection >= files.size()) {
-        selection = 0;
-    }
+            if(entry.isDirectory) {
+                flags |= FLAG_DIRECTORY;
+            } else if(isRomExtension(extension)) {
+                flags |= FLAG_ROM;
 
-    if(!initialSelection.empty()) {
-        for(u32 i = 0; i < files.size(); i++) {
-            if(initialSelection == files[i].name) {
-                selection = i;
-                break;
+                romIndexQueue(directory + fullName);
+
+                if(states.find(name) != states.end()) {
+                    flags |= FLAG_SUSPENDED;
+                }
             }
-        }
 
-        initialSelection = "";
+            files.push_back({fullName, flags});
+        }
     }
 
-    scrollY = 0;
-    updateScrollDown();
-}
\ No newline at end of file
+    // Catch up on ROMs listed before their save state was seen.
+    if(newStates) {
+        for(FileEntry& file : files) {
+            if((file.flags & (FLAG_ROM | FLAG_SUSPENDED)) == FLAG_ROM && states.find(file.name.substr(0, file.name.rfind('.'))) != states.end()) {
+                file.flags |= FLAG_SUSPENDED;
+            }
+        }
+    }
+}
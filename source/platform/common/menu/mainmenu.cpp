@@ -5,8 +5,10 @@
 #include "platform/common/menu/filechooser.h"
 #include "platform/common/menu/mainmenu.h"
 #include "platform/common/menu/rominfo.h"
+#include "platform/common/capture.h"
 #include "platform/common/config.h"
 #include "platform/common/manager.h"
+#include "platform/common/movie.h"
 #include "platform/system.h"
 #include "platform/ui.h"
 #include "cartridge.h"
@@ -21,12 +23,18 @@
 #define ACTION_MENU_SAVE_STATE 4
 #define ACTION_MENU_LOAD_STATE 5
 #define ACTION_MENU_DELETE_STATE 6
-#define ACTION_MENU_ROM_INFO 7
-#define ACTION_MENU_BUTTON_MAPPING 8
-#define ACTION_MENU_MANAGE_CHEATS 9
-#define ACTION_MENU_SAVE_SETTINGS 10
-#define ACTION_MENU_EXIT_WITHOUT_SAVING 11
-#define ACTION_MENU_QUIT_TO_LAUNCHER 12
+#define ACTION_MENU_RECORD_MOVIE 7
+#define ACTION_MENU_RECORD_MOVIE_FROM_RESET 8
+#define ACTION_MENU_PLAY_MOVIE 9
+#define ACTION_MENU_STOP_MOVIE 10
+#define ACTION_MENU_START_CAPTURE 11
+#define ACTION_MENU_STOP_CAPTURE 12
+#define ACTION_MENU_ROM_INFO 13
+#define ACTION_MENU_BUTTON_MAPPING 14
+#define ACTION_MENU_MANAGE_CHEATS 15
+#define ACTION_MENU_SAVE_SETTINGS 16
+#define ACTION_MENU_EXIT_WITHOUT_SAVING 17
+#define ACTION_MENU_QUIT_TO_LAUNCHER 18
 
 #define STATE_SLOT_MIN 0
 #define STATE_SLOT_MAX 9
@@ -259,6 +267,12 @@ void MainMenu::updateGameStatus() {
     setItemEnabled(ACTION_MENU, ACTION_MENU_SAVE_STATE, cartLoaded);
     setItemEnabled(ACTION_MENU, ACTION_MENU_LOAD_STATE, cartLoaded && stateExists);
     setItemEnabled(ACTION_MENU, ACTION_MENU_DELETE_STATE, cartLoaded && stateExists);
+    setItemEnabled(ACTION_MENU, ACTION_MENU_RECORD_MOVIE, cartLoaded);
+    setItemEnabled(ACTION_MENU, ACTION_MENU_RECORD_MOVIE_FROM_RESET, cartLoaded);
+    setItemEnabled(ACTION_MENU, ACTION_MENU_PLAY_MOVIE, cartLoaded && mgrMovieExists());
+    setItemEnabled(ACTION_MENU, ACTION_MENU_STOP_MOVIE, movieIsRecording() || movieIsPlaying());
+    setItemEnabled(ACTION_MENU, ACTION_MENU_START_CAPTURE, cartLoaded && !captureIsRecording());
+    setItemEnabled(ACTION_MENU, ACTION_MENU_STOP_CAPTURE, captureIsRecording());
     setItemEnabled(ACTION_MENU, ACTION_MENU_ROM_INFO, cartLoaded);
     setItemEnabled(ACTION_MENU, ACTION_MENU_MANAGE_CHEATS, cartLoaded);
 }
@@ -443,6 +457,54 @@ void MainMenu::deleteState() {
     updateGameStatus();
 }
 
+void MainMenu::recordMovie() {
+    if(!mgrRecordMovie(false)) {
+        printMessage("Could not record movie.");
+        return;
+    }
+
+    menuPop();
+}
+
+void MainMenu::recordMovieFromReset() {
+    if(!mgrRecordMovie(true)) {
+        printMessage("Could not record movie.");
+        return;
+    }
+
+    menuPop();
+}
+
+void MainMenu::playMovie() {
+    if(!mgrPlayMovie()) {
+        printMessage("Could not play movie.");
+        return;
+    }
+
+    menuPop();
+}
+
+void MainMenu::stopMovie() {
+    mgrStopMovie();
+
+    updateGameStatus();
+}
+
+void MainMenu::startCapture() {
+    if(!mgrStartCapture()) {
+        printMessage("Could not start capture.");
+        return;
+    }
+
+    menuPop();
+}
+
+void MainMenu::stopCapture() {
+    mgrStopCapture();
+
+    updateGameStatus();
+}
+
 void MainMenu::romInfo() {
     menuPush(new RomInfoMenu());
 }
@@ -61,6 +61,8 @@ void menuUpdate() {
                 redraw = true;
             }
 
+            redraw = menu->update() || redraw;
+
             if(redraw) {
                 uiGetSize(&width, &height);
 
@@ -0,0 +1,318 @@
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include "platform/common/movie.h"
+#include "cartridge.h"
+#include "gameboy.h"
+
+#define MOVIE_MAGIC "GYMV"
+#define MOVIE_VERSION 2
+
+#define MOVIE_ANCHOR_POWER_ON 0
+#define MOVIE_ANCHOR_STATE 1
+
+// Each record is a type byte followed by a fixed payload. A frame record starts every
+// frame, and is followed by any inputs the game asked for during that frame.
+#define MOVIE_RECORD_FRAME 0x01
+#define MOVIE_RECORD_TIME 0x02
+#define MOVIE_RECORD_TILT 0x03
+#define MOVIE_RECORD_CAMERA 0x04
+
+#define MOVIE_CAMERA_PIXELS (128 * 120)
+
+// Options that decide how the game is emulated; these are fixed for the length of a movie.
+#define MOVIE_NUM_OPTIONS (GB_OPT_PRINTER_ENABLED + 1)
+
+static Gameboy* gameboy = nullptr;
+static GameboySettings liveSettings;
+
+static std::ofstream recordStream;
+static std::ifstream playStream;
+
+static u8 playVersion = 0;
+
+static u8 options[MOVIE_NUM_OPTIONS];
+static u32 cameraImage[MOVIE_CAMERA_PIXELS];
+
+static void moviePrint(const char* str) {
+    if(liveSettings.printDebug != nullptr) {
+        liveSettings.printDebug("%s", str);
+    }
+}
+
+static void movieWrite(u8 type, const void* data, size_t size) {
+    recordStream.put((char) type);
+    recordStream.write((const char*) data, size);
+}
+
+static bool movieRead(u8 type, void* data, size_t size) {
+    int next = playStream.get();
+    if(next == type) {
+        playStream.read((char*) data, size);
+        if((size_t) playStream.gcount() == size) {
+            return true;
+        }
+    }
+
+    moviePrint(next == EOF ? "Movie playback finished.\n" : "Movie playback desynced.\n");
+    movieStop();
+    return false;
+}
+
+static void movieWriteBlock(const std::string& block) {
+    u32 size = (u32) block.size();
+    recordStream.write((const char*) &size, sizeof(size));
+    recordStream.write(block.data(), size);
+}
+
+static bool movieReadBlock(std::string& block) {
+    u32 size = 0;
+    playStream.read((char*) &size, sizeof(size));
+    if(!playStream.good()) {
+        return false;
+    }
+
+    block.resize(size);
+    playStream.read(&block[0], size);
+    return (u32) playStream.gcount() == size;
+}
+
+static u64 movieGetTime() {
+    u64 now = 0;
+    if(movieIsPlaying() && movieRead(MOVIE_RECORD_TIME, &now, sizeof(now))) {
+        return now;
+    }
+
+    now = liveSettings.getTime != nullptr ? liveSettings.getTime() : (u64) time(nullptr);
+
+    if(movieIsRecording()) {
+        movieWrite(MOVIE_RECORD_TIME, &now, sizeof(now));
+    }
+
+    return now;
+}
+
+static void movieReadTilt(u16* x, u16* y) {
+    u16 tilt[2];
+
+    if(movieIsPlaying() && movieRead(MOVIE_RECORD_TILT, tilt, sizeof(tilt))) {
+        *x = tilt[0];
+        *y = tilt[1];
+        return;
+    }
+
+    if(liveSettings.readTilt != nullptr) {
+        liveSettings.readTilt(x, y);
+    }
+
+    if(movieIsRecording()) {
+        tilt[0] = *x;
+        tilt[1] = *y;
+        movieWrite(MOVIE_RECORD_TILT, tilt, sizeof(tilt));
+    }
+}
+
+static u32* movieGetCameraImage() {
+    u8 present = 0;
+
+    if(movieIsPlaying() && movieRead(MOVIE_RECORD_CAMERA, &present, sizeof(present))) {
+        if(present == 0) {
+            return nullptr;
+        }
+
+        playStream.read((char*) cameraImage, sizeof(cameraImage));
+        if(playStream.gcount() == sizeof(cameraImage)) {
+            return cameraImage;
+        }
+
+        moviePrint("Movie playback finished.\n");
+        movieStop();
+    }
+
+    u32* image = liveSettings.getCameraImage != nullptr ? liveSettings.getCameraImage() : nullptr;
+
+    if(movieIsRecording()) {
+        present = (u8) (image != nullptr);
+        movieWrite(MOVIE_RECORD_CAMERA, &present, sizeof(present));
+
+        if(image != nullptr) {
+            recordStream.write((const char*) image, sizeof(cameraImage));
+        }
+    }
+
+    return image;
+}
+
+static u8 movieGetOption(GameboyOption opt) {
+    if(opt < MOVIE_NUM_OPTIONS) {
+        return options[opt];
+    }
+
+    return liveSettings.getOption(opt);
+}
+
+static void movieHook(Gameboy* gb) {
+    gameboy = gb;
+    liveSettings = gb->settings;
+
+    gb->settings.getTime = movieGetTime;
+    gb->settings.readTilt = movieReadTilt;
+    gb->settings.getCameraImage = movieGetCameraImage;
+    gb->settings.getOption = movieGetOption;
+}
+
+bool movieRecord(Gameboy* gb, const std::string& path, bool powerOn) {
+    movieStop();
+
+    if(gb == nullptr || gb->cartridge == nullptr) {
+        return false;
+    }
+
+    recordStream.open(path, std::ios::binary | std::ios::trunc);
+    if(!recordStream.is_open()) {
+        return false;
+    }
+
+    for(u8 i = 0; i < MOVIE_NUM_OPTIONS; i++) {
+        options[i] = gb->settings.getOption((GameboyOption) i);
+    }
+
+    u8 version = MOVIE_VERSION;
+    u8 anchor = powerOn ? MOVIE_ANCHOR_POWER_ON : MOVIE_ANCHOR_STATE;
+    u64 hash = gb->cartridge->getRomHash();
+
+    recordStream.write(MOVIE_MAGIC, 4);
+    recordStream.write((const char*) &version, sizeof(version));
+    recordStream.write((const char*) &anchor, sizeof(anchor));
+    recordStream.write((const char*) &hash, sizeof(hash));
+    recordStream.write((const char*) options, sizeof(options));
+
+    std::stringstream battery;
+    gb->cartridge->saveBattery(battery);
+    movieWriteBlock(battery.str());
+
+    if(powerOn) {
+        movieHook(gb);
+
+        gb->powerOff();
+        gb->powerOn();
+    } else {
+        std::stringstream state;
+        gb->saveState(state);
+        movieWriteBlock(state.str());
+
+        movieHook(gb);
+    }
+
+    if(!recordStream.good()) {
+        movieStop();
+        return false;
+    }
+
+    return true;
+}
+
+bool moviePlay(Gameboy* gb, const std::string& path) {
+    movieStop();
+
+    if(gb == nullptr || gb->cartridge == nullptr) {
+        return false;
+    }
+
+    playStream.open(path, std::ios::binary);
+    if(!playStream.is_open()) {
+        return false;
+    }
+
+    char magic[4] = {0};
+    u8 version = 0;
+    u8 anchor = 0;
+    u64 hash = 0;
+
+    playStream.read(magic, sizeof(magic));
+    playStream.read((char*) &version, sizeof(version));
+    playStream.read((char*) &anchor, sizeof(anchor));
+    playStream.read((char*) &hash, sizeof(hash));
+    playStream.read((char*) options, sizeof(options));
+
+    std::string battery;
+    std::string state;
+    // Version 1 movies only recorded the first controller.
+    if(memcmp(magic, MOVIE_MAGIC, sizeof(magic)) != 0 || version < 1 || version > MOVIE_VERSION || hash != gb->cartridge->getRomHash()
+       || !movieReadBlock(battery) || (anchor == MOVIE_ANCHOR_STATE && !movieReadBlock(state))) {
+        playStream.close();
+        return false;
+    }
+
+    playVersion = version;
+
+    // Keep the real SRAM around, so a movie that fails to start doesn't leave its own in place to be saved.
+    std::stringstream liveBattery;
+    gb->cartridge->saveBattery(liveBattery);
+
+    movieHook(gb);
+
+    gb->powerOff();
+
+    std::istringstream batteryStream(battery);
+    gb->cartridge->loadBattery(batteryStream);
+
+    gb->powerOn();
+
+    if(anchor == MOVIE_ANCHOR_STATE) {
+        std::istringstream stateStream(state);
+        if(!gb->loadState(stateStream)) {
+            movieStop();
+
+            gb->powerOff();
+            gb->cartridge->loadBattery(liveBattery);
+            gb->powerOn();
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void movieStop() {
+    if(recordStream.is_open()) {
+        recordStream.close();
+    }
+
+    if(playStream.is_open()) {
+        playStream.close();
+    }
+
+    if(gameboy != nullptr) {
+        gameboy->settings.getTime = liveSettings.getTime;
+        gameboy->settings.readTilt = liveSettings.readTilt;
+        gameboy->settings.getCameraImage = liveSettings.getCameraImage;
+        gameboy->settings.getOption = liveSettings.getOption;
+
+        gameboy = nullptr;
+    }
+}
+
+bool movieIsRecording() {
+    return recordStream.is_open();
+}
+
+bool movieIsPlaying() {
+    return playStream.is_open();
+}
+
+void movieUpdate(u8* buttons) {
+    if(movieIsRecording()) {
+        movieWrite(MOVIE_RECORD_FRAME, buttons, SGB_MAX_CONTROLLERS);
+    } else if(movieIsPlaying()) {
+        u8 recorded[SGB_MAX_CONTROLLERS];
+        memset(recorded, 0xFF, sizeof(recorded));
+
+        if(movieRead(MOVIE_RECORD_FRAME, recorded, playVersion == 1 ? 1 : sizeof(recorded))) {
+            memcpy(buttons, recorded, sizeof(recorded));
+        }
+    }
+}
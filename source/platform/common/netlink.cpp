@@ -0,0 +1,527 @@
+#include "platform/common/config.h"
+
+#ifdef GAMEBOY_LINK_CABLE
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <sstream>
+#include <vector>
+
+#include "platform/common/netlink.h"
+#include "cartridge.h"
+#include "gameboy.h"
+
+#define NETLINK_SOCKET_PATH "/tmp/gameyob-link.sock"
+#define NETLINK_TCP_PORT 5738
+
+#define NETLINK_CONNECT_RETRY_FRAMES 60
+#define NETLINK_REPLY_TIMEOUT_MS 1000
+
+// Each message is a type byte, a data byte and a 16-bit sequence number.
+#define NETLINK_MSG_SIZE 4
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define NETLINK_MSG_TRANSFER 0x01
+#define NETLINK_MSG_REPLY 0x02
+
+typedef struct {
+    u8 data;
+    u16 seq;
+    u64 cycle;
+} NetlinkIncoming;
+
+// A byte the peer clocked into us, either at the start of a frame (poll 0) or on a poll within it.
+typedef struct {
+    u32 frame;
+    u32 poll;
+    u8 data;
+} NetlinkReceived;
+
+static Gameboy* gameboy = nullptr;
+static bool hosting = false;
+static NetlinkTransport transport = NETLINK_TRANSPORT_LOCAL;
+
+static int listenFd = -1;
+static int peerFd = -1;
+static u32 retryCounter = 0;
+
+static u8 recvBuffer[NETLINK_MSG_SIZE];
+static u32 recvFill = 0;
+
+static std::deque<NetlinkIncoming> incoming;
+
+// At most one transfer is ever unconfirmed. The window starts at the last frame with nothing
+// unconfirmed, and holds what is needed to replay from there: a snapshot, the inputs of each
+// frame, the reply to each transfer, and the transfers the peer clocked into us.
+static u16 nextSeq = 0;
+static bool pending = false;
+static u16 pendingSeq = 0;
+static u32 pendingIndex = 0;
+static bool rollbackPending = false;
+static u8 lastPeerByte = 0xFF;
+
+static bool windowOpen = false;
+static std::string snapshot;
+static std::vector<u8> frameInputs;
+static std::vector<u8> replies;
+static u32 replyIndex = 0;
+static std::vector<NetlinkReceived> received;
+static u32 receivedIndex = 0;
+static u32 currFrame = 0;
+static u32 currPoll = 0;
+
+static void netlinkPrint(const char* str) {
+    if(gameboy != nullptr && gameboy->settings.printDebug != nullptr) {
+        gameboy->settings.printDebug("%s", str);
+    }
+}
+
+static void netlinkCloseFd(int& fd) {
+    if(fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+static void netlinkSetNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static int netlinkSocket() {
+    if(transport == NETLINK_TRANSPORT_TCP) {
+        return socket(AF_INET, SOCK_STREAM, 0);
+    }
+
+    return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+static socklen_t netlinkAddress(sockaddr_storage* addr) {
+    memset(addr, 0, sizeof(*addr));
+
+    if(transport == NETLINK_TRANSPORT_TCP) {
+        sockaddr_in* in = (sockaddr_in*) addr;
+        in->sin_family = AF_INET;
+        in->sin_port = htons(NETLINK_TCP_PORT);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sizeof(sockaddr_in);
+    }
+
+    sockaddr_un* un = (sockaddr_un*) addr;
+    un->sun_family = AF_UNIX;
+    strncpy(un->sun_path, NETLINK_SOCKET_PATH, sizeof(un->sun_path) - 1);
+    return sizeof(sockaddr_un);
+}
+
+static void netlinkInitPeer() {
+    netlinkSetNonBlocking(peerFd);
+
+    if(transport == NETLINK_TRANSPORT_TCP) {
+        int noDelay = 1;
+        setsockopt(peerFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+
+    recvFill = 0;
+    netlinkPrint("Link cable connected.\n");
+}
+
+static bool netlinkListen() {
+    listenFd = netlinkSocket();
+    if(listenFd < 0) {
+        return false;
+    }
+
+    if(transport == NETLINK_TRANSPORT_TCP) {
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    } else {
+        unlink(NETLINK_SOCKET_PATH);
+    }
+
+    sockaddr_storage addr;
+    socklen_t addrLen = netlinkAddress(&addr);
+    if(bind(listenFd, (sockaddr*) &addr, addrLen) != 0 || listen(listenFd, 1) != 0) {
+        netlinkCloseFd(listenFd);
+        return false;
+    }
+
+    netlinkSetNonBlocking(listenFd);
+    return true;
+}
+
+static void netlinkConnect() {
+    if(hosting) {
+        peerFd = accept(listenFd, nullptr, nullptr);
+    } else {
+        // Only retry occasionally, so a missing host doesn't cost a syscall every frame.
+        if(retryCounter++ % NETLINK_CONNECT_RETRY_FRAMES != 0) {
+            return;
+        }
+
+        peerFd = netlinkSocket();
+        if(peerFd < 0) {
+            return;
+        }
+
+        sockaddr_storage addr;
+        socklen_t addrLen = netlinkAddress(&addr);
+        if(connect(peerFd, (sockaddr*) &addr, addrLen) != 0) {
+            netlinkCloseFd(peerFd);
+        }
+    }
+
+    if(peerFd >= 0) {
+        netlinkInitPeer();
+    }
+}
+
+static void netlinkCloseWindow() {
+    pending = false;
+    rollbackPending = false;
+
+    windowOpen = false;
+    snapshot.clear();
+    frameInputs.clear();
+    replies.clear();
+    replyIndex = 0;
+    received.clear();
+    receivedIndex = 0;
+}
+
+static void netlinkDisconnect() {
+    if(peerFd >= 0) {
+        netlinkCloseFd(peerFd);
+        netlinkPrint("Link cable disconnected.\n");
+    }
+
+    // Whatever was guessed for an unanswered transfer stands.
+    netlinkCloseWindow();
+    incoming.clear();
+    lastPeerByte = 0xFF;
+    retryCounter = 0;
+}
+
+static void netlinkSend(u8 type, u8 data, u16 seq) {
+    u8 msg[NETLINK_MSG_SIZE] = {type, data, (u8) (seq & 0xFF), (u8) (seq >> 8)};
+    if(send(peerFd, msg, sizeof(msg), MSG_NOSIGNAL) != sizeof(msg)) {
+        netlinkDisconnect();
+    }
+}
+
+static void netlinkHandle(u8 type, u8 data, u16 seq) {
+    if(type == NETLINK_MSG_TRANSFER) {
+        // The peer is driving the clock; the byte is shifted in at our next poll or frame.
+        incoming.push_back({data, seq, gameboy->cpu.getCycle()});
+    } else if(type == NETLINK_MSG_REPLY && pending && seq == pendingSeq) {
+        pending = false;
+        lastPeerByte = data;
+
+        if(replies[pendingIndex] != data) {
+            replies[pendingIndex] = data;
+            rollbackPending = true;
+        }
+    }
+}
+
+static void netlinkProcess(int timeoutMs) {
+    if(peerFd < 0) {
+        return;
+    }
+
+    pollfd pfd = {peerFd, POLLIN, 0};
+    if(poll(&pfd, 1, timeoutMs) <= 0) {
+        return;
+    }
+
+    while(peerFd >= 0) {
+        ssize_t count = recv(peerFd, &recvBuffer[recvFill], NETLINK_MSG_SIZE - recvFill, 0);
+        if(count <= 0) {
+            if(count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                netlinkDisconnect();
+            }
+
+            break;
+        }
+
+        recvFill += (u32) count;
+        if(recvFill == NETLINK_MSG_SIZE) {
+            recvFill = 0;
+            netlinkHandle(recvBuffer[0], recvBuffer[1], (u16) (recvBuffer[2] | (recvBuffer[3] << 8)));
+        }
+    }
+}
+
+static void netlinkReceive(u32 poll, u8 data, u16 seq, u8 reply) {
+    if(windowOpen) {
+        received.push_back({currFrame, poll, data});
+        receivedIndex++;
+    }
+
+    netlinkSend(NETLINK_MSG_REPLY, reply, seq);
+}
+
+static void netlinkWaitForReply() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(NETLINK_REPLY_TIMEOUT_MS);
+
+    while(pending && peerFd >= 0) {
+        s64 remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if(remaining <= 0) {
+            netlinkPrint("Link cable timed out.\n");
+            netlinkDisconnect();
+            break;
+        }
+
+        // If the peer is driving the clock too, it is waiting on us; we aren't listening for a byte.
+        // Answer before blocking, or both sides sit out the timeout on each other.
+        while(!incoming.empty() && peerFd >= 0) {
+            NetlinkIncoming msg = incoming.front();
+            incoming.pop_front();
+
+            netlinkSend(NETLINK_MSG_REPLY, 0xFF, msg.seq);
+        }
+
+        netlinkProcess((int) remaining);
+    }
+}
+
+static u8 netlinkTransfer(u8 data) {
+    // Transfers replayed after a rollback already know their replies.
+    if(replyIndex < replies.size()) {
+        return replies[replyIndex++];
+    }
+
+    if(peerFd < 0) {
+        return 0xFF;
+    }
+
+    // Only speculate one byte ahead, so the peer never receives a byte computed from a wrong guess.
+    if(pending) {
+        netlinkWaitForReply();
+    }
+
+    if(rollbackPending || peerFd < 0 || !windowOpen) {
+        // This frame will be replayed anyway.
+        return lastPeerByte;
+    }
+
+    pending = true;
+    pendingSeq = nextSeq++;
+    pendingIndex = (u32) replies.size();
+
+    replies.push_back(lastPeerByte);
+    replyIndex++;
+
+    netlinkSend(NETLINK_MSG_TRANSFER, data, pendingSeq);
+    return lastPeerByte;
+}
+
+static bool netlinkPoll(u8 val, u8* data) {
+    currPoll++;
+
+    // Bytes replayed after a rollback arrive on the same poll they did the first time around.
+    if(receivedIndex < received.size()) {
+        const NetlinkReceived& entry = received[receivedIndex];
+        if(entry.frame == currFrame && entry.poll <= currPoll) {
+            receivedIndex++;
+
+            *data = entry.data;
+            return true;
+        }
+
+        return false;
+    }
+
+    netlinkProcess(0);
+
+    // Until our own transfer is confirmed, SB may rest on a wrong guess; the peer's byte waits for it.
+    if(pending || rollbackPending || incoming.empty()) {
+        return false;
+    }
+
+    NetlinkIncoming msg = incoming.front();
+    incoming.pop_front();
+
+    netlinkReceive(currPoll, msg.data, msg.seq, val);
+
+    *data = msg.data;
+    return true;
+}
+
+// Plugged into the GameBoy's serial port while the link is running.
+class NetlinkPort : public SerialLink {
+public:
+    u8 transfer(u64 cycle, u8 val) {
+        return netlinkTransfer(val);
+    }
+
+    bool poll(u64 cycle, u8 val, u8* received) {
+        return netlinkPoll(val, received);
+    }
+};
+
+static NetlinkPort port;
+
+static void netlinkApplyReceived() {
+    // Shift in any replayed bytes due by the start of this frame, including any the replay didn't poll for.
+    while(receivedIndex < received.size()) {
+        const NetlinkReceived& entry = received[receivedIndex];
+        if(entry.frame > currFrame || (entry.frame == currFrame && entry.poll != 0)) {
+            break;
+        }
+
+        receivedIndex++;
+        gameboy->serial.linkReceive(entry.data);
+    }
+}
+
+static void netlinkRollback() {
+    rollbackPending = false;
+
+    std::istringstream stream(snapshot);
+    gameboy->cartridge->loadBattery(stream);
+    gameboy->loadState(stream);
+
+    replyIndex = 0;
+    receivedIndex = 0;
+
+    u32 frames = (u32) (frameInputs.size() / SGB_MAX_CONTROLLERS);
+    for(currFrame = 0; currFrame < frames && windowOpen; currFrame++) {
+        currPoll = 0;
+        netlinkApplyReceived();
+
+        for(u8 controller = 0; controller < SGB_MAX_CONTROLLERS; controller++) {
+            gameboy->sgb.setController(controller, frameInputs[currFrame * SGB_MAX_CONTROLLERS + controller]);
+        }
+
+        gameboy->runFrame();
+    }
+
+    while(receivedIndex < received.size()) {
+        gameboy->serial.linkReceive(received[receivedIndex++].data);
+    }
+}
+
+bool netlinkStart(Gameboy* gb, bool host, NetlinkTransport linkTransport) {
+    netlinkStop();
+
+    gameboy = gb;
+    hosting = host;
+    transport = linkTransport;
+
+    if(hosting && !netlinkListen()) {
+        gameboy = nullptr;
+        return false;
+    }
+
+    retryCounter = 0;
+    gameboy->serial.setLink(&port);
+    return true;
+}
+
+void netlinkStop() {
+    if(gameboy == nullptr) {
+        return;
+    }
+
+    netlinkDisconnect();
+
+    if(listenFd >= 0) {
+        netlinkCloseFd(listenFd);
+
+        if(transport == NETLINK_TRANSPORT_LOCAL) {
+            unlink(NETLINK_SOCKET_PATH);
+        }
+    }
+
+    gameboy->serial.setLink(nullptr);
+    gameboy = nullptr;
+}
+
+bool netlinkIsStarted() {
+    return gameboy != nullptr;
+}
+
+bool netlinkIsConnected() {
+    return peerFd >= 0;
+}
+
+void netlinkBeginFrame(const u8* buttons) {
+    if(gameboy == nullptr || !gameboy->isPoweredOn() || gameboy->cartridge == nullptr) {
+        return;
+    }
+
+    if(peerFd < 0) {
+        netlinkConnect();
+        if(peerFd < 0) {
+            return;
+        }
+    }
+
+    currFrame = (u32) (frameInputs.size() / SGB_MAX_CONTROLLERS);
+    currPoll = 0;
+
+    netlinkProcess(0);
+
+    // Bytes that waited a whole frame without us listening for one still get an answer.
+    u64 cycle = gameboy->cpu.getCycle();
+    while(!incoming.empty() && peerFd >= 0 && (cycle < incoming.front().cycle || cycle - incoming.front().cycle >= CYCLES_PER_FRAME)) {
+        // Neither shift nor answer on top of a guess. The peer may be waiting on us for the same
+        // reason, so this answers its transfers the way two sides both driving the clock would.
+        if(pending) {
+            netlinkWaitForReply();
+            continue;
+        }
+
+        NetlinkIncoming msg = incoming.front();
+        incoming.pop_front();
+
+        netlinkReceive(0, msg.data, msg.seq, gameboy->serial.linkReceive(msg.data));
+    }
+
+    // With nothing left to confirm, start a new window here.
+    if(!pending && !rollbackPending && replyIndex >= replies.size()) {
+        netlinkCloseWindow();
+
+        std::ostringstream stream;
+        gameboy->cartridge->saveBattery(stream);
+        gameboy->saveState(stream);
+        snapshot = stream.str();
+
+        windowOpen = true;
+        currFrame = 0;
+    }
+
+    frameInputs.insert(frameInputs.end(), buttons, buttons + SGB_MAX_CONTROLLERS);
+}
+
+void netlinkEndFrame() {
+    if(!windowOpen) {
+        return;
+    }
+
+    netlinkProcess(0);
+
+    // Replaying may itself guess wrong, in which case go around again.
+    while(rollbackPending && windowOpen) {
+        netlinkRollback();
+    }
+}
+
+void netlinkResync() {
+    netlinkCloseWindow();
+}
+
+#endif
@@ -0,0 +1,210 @@
+#include <unistd.h>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "platform/common/printout.h"
+#include "printer.h"
+
+// Bands are converted and written on a worker thread, so a long print never holds up emulation.
+// Each print keeps its file open for as long as bands are being appended to it; the header is
+// patched in place after every band so the file on disk is always a complete image.
+
+#define PRINTOUT_HEADER_SIZE 0x46
+#define PRINTOUT_BAND_BYTES (PRINTER_WIDTH / 4 * 16)
+
+typedef struct {
+    std::ofstream stream;
+    u8 palette;
+    u32 height;
+} PrintJob;
+
+typedef struct {
+    std::shared_ptr<PrintJob> job;
+    std::vector<u8> data;
+} PrintBand;
+
+static std::thread writer;
+static std::mutex queueMutex;
+static std::condition_variable queueCond;
+static std::deque<PrintBand> queue;
+static bool stopRequested = false;
+
+static std::shared_ptr<PrintJob> currJob;
+
+static std::string indexBasePath;
+static u32 nextIndex = 0;
+
+static u32 tileRowLUT[0x100];
+
+static void printoutInitLUT() {
+    // Spreads one bitplane of a tile row over eight 4bpp pixels, leftmost pixel in the high nibble.
+    for(u32 bits = 0; bits < 0x100; bits++) {
+        u32 pixels = 0;
+        for(u32 x = 0; x < 8; x++) {
+            if(bits & (0x80 >> x)) {
+                pixels |= 1 << ((x / 2) * 8 + ((x & 1) ? 0 : 4));
+            }
+        }
+
+        tileRowLUT[bits] = pixels;
+    }
+}
+
+static void printoutWriteHeader(PrintJob* job) {
+    u32 pixelArraySize = PRINTER_WIDTH / 2 * job->height;
+
+    u8 header[PRINTOUT_HEADER_SIZE] = {
+            0x42, 0x4d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00, 0x28, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x04, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0x0b, 0x00, 0x00, 0x12, 0x0b, 0x00, 0x00, 0x04, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+
+    *(u32*) (header + 0x02) = PRINTOUT_HEADER_SIZE + pixelArraySize;
+    *(u32*) (header + 0x12) = PRINTER_WIDTH;
+    *(u32*) (header + 0x16) = (u32) -(s32) job->height; // Top-down, so bands can simply be appended.
+    *(u32*) (header + 0x22) = pixelArraySize;
+
+    static const u8 shades[4] = {0xFF, 0xAA, 0x55, 0x00};
+    for(int i = 0; i < 4; i++) {
+        u8 rgb = shades[(job->palette >> (i * 2)) & 3];
+        for(int j = 0; j < 4; j++) {
+            header[0x36 + i * 4 + j] = rgb;
+        }
+    }
+
+    job->stream.seekp(0);
+    job->stream.write((const char*) header, sizeof(header));
+}
+
+static void printoutWriteBand(PrintBand& band) {
+    PrintJob* job = band.job.get();
+
+    u32 size = (u32) band.data.size();
+    u32 height = size / (PRINTER_WIDTH / 4);
+
+    // Convert the printer's tile-based 2bpp into linear 4bpp rows.
+    std::vector<u32> pixels(PRINTER_WIDTH / 8 * height);
+    for(u32 i = 0; i < size; i += 2) {
+        u32 tile = i / 16;
+        u32 y = (tile / 20) * 8 + (i % 16) / 2;
+        u32 x = tile % 20;
+
+        pixels[y * (PRINTER_WIDTH / 8) + x] = tileRowLUT[band.data[i]] | (tileRowLUT[band.data[i + 1]] << 1);
+    }
+
+    if(job->height == 0) {
+        printoutWriteHeader(job);
+    }
+
+    job->stream.seekp(0, std::ios::end);
+    job->stream.write((const char*) &pixels[0], pixels.size() * sizeof(u32));
+
+    job->height += height;
+    printoutWriteHeader(job);
+
+    job->stream.flush();
+}
+
+static void printoutWriterThread() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+
+    while(true) {
+        queueCond.wait(lock, [] { return !queue.empty() || stopRequested; });
+        if(queue.empty()) {
+            break;
+        }
+
+        PrintBand band = std::move(queue.front());
+        queue.pop_front();
+
+        lock.unlock();
+        printoutWriteBand(band);
+        band.job.reset();
+        lock.lock();
+    }
+}
+
+static std::shared_ptr<PrintJob> printoutStartJob(const std::string& basePath, u8 palette) {
+    // Find the first free file once per base path, then count up from there.
+    if(basePath != indexBasePath) {
+        indexBasePath = basePath;
+        nextIndex = 0;
+
+        while(true) {
+            std::stringstream stream;
+            stream << basePath << "-" << nextIndex << ".bmp";
+            if(access(stream.str().c_str(), R_OK) != 0) {
+                break;
+            }
+
+            nextIndex++;
+        }
+    }
+
+    std::stringstream stream;
+    stream << basePath << "-" << nextIndex << ".bmp";
+
+    std::shared_ptr<PrintJob> job = std::make_shared<PrintJob>();
+    job->stream.open(stream.str(), std::ios::binary | std::ios::trunc);
+    if(!job->stream.is_open()) {
+        return nullptr;
+    }
+
+    job->palette = palette;
+    job->height = 0;
+
+    nextIndex++;
+    return job;
+}
+
+bool printoutBand(const std::string& basePath, bool appending, const u8* buf, int size, u8 palette) {
+    if(!appending || currJob == nullptr || basePath != indexBasePath) {
+        currJob = printoutStartJob(basePath, palette);
+        if(currJob == nullptr) {
+            return false;
+        }
+    }
+
+    if(!writer.joinable()) {
+        printoutInitLUT();
+
+        stopRequested = false;
+        writer = std::thread(printoutWriterThread);
+    }
+
+    // In case of error, size must be rounded off to the nearest 16 vertical pixels.
+    if(size % PRINTOUT_BAND_BYTES != 0) {
+        size += PRINTOUT_BAND_BYTES - (size % PRINTOUT_BAND_BYTES);
+    }
+
+    PrintBand band;
+    band.job = currJob;
+    band.data.assign(buf, buf + size);
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.push_back(std::move(band));
+    queueCond.notify_all();
+    return true;
+}
+
+void printoutStop() {
+    if(writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopRequested = true;
+            queueCond.notify_all();
+        }
+
+        writer.join();
+    }
+
+    currJob.reset();
+}
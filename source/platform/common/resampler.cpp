@@ -0,0 +1,192 @@
+#include <cmath>
+#include <cstring>
+
+#include "platform/common/resampler.h"
+#include "simd.h"
+
+#define RESAMPLER_TAPS 32
+#define RESAMPLER_PHASE_BITS 8
+#define RESAMPLER_PHASES (1 << RESAMPLER_PHASE_BITS)
+
+// Fraction of the lower Nyquist frequency to pass, leaving room for the transition band.
+#define RESAMPLER_CUTOFF 0.9
+
+#define RESAMPLER_COEF_BITS 15
+
+// Enough for a frame of input at any supported rate, plus the filter's history.
+#define RESAMPLER_HISTORY (RESAMPLER_TAPS + 4096)
+
+static bool active = false;
+
+static s16 coefs[RESAMPLER_PHASES][RESAMPLER_TAPS];
+
+// De-interleaved so each channel's taps are contiguous.
+static s16 historyLeft[RESAMPLER_HISTORY];
+static s16 historyRight[RESAMPLER_HISTORY];
+static u32 historyLength;
+
+// Input position of the next output sample, in 32.32 fixed point relative to the start of history.
+static u64 position;
+static u64 step;
+
+void resamplerInit(u32 inRate, u32 outRate) {
+    active = inRate != 0 && outRate != 0 && inRate != outRate;
+    if(!active) {
+        return;
+    }
+
+    step = ((u64) inRate << 32) / outRate;
+
+    // Cut off at the lower of the two Nyquist frequencies, relative to the input rate.
+    double cutoff = 0.5 * RESAMPLER_CUTOFF * (inRate < outRate ? inRate : outRate) / inRate;
+
+    for(u32 phase = 0; phase < RESAMPLER_PHASES; phase++) {
+        double taps[RESAMPLER_TAPS];
+        double sum = 0;
+
+        for(u32 tap = 0; tap < RESAMPLER_TAPS; tap++) {
+            // Distance from the output point, which sits between taps TAPS / 2 - 1 and TAPS / 2.
+            double x = (double) tap - (RESAMPLER_TAPS / 2 - 1) - (double) phase / RESAMPLER_PHASES;
+            double sinc = x == 0 ? 1 : sin(M_PI * 2 * cutoff * x) / (M_PI * 2 * cutoff * x);
+
+            // Blackman window over the span of the filter.
+            double w = (x + RESAMPLER_TAPS / 2) / RESAMPLER_TAPS;
+            double window = 0.42 - 0.5 * cos(2 * M_PI * w) + 0.08 * cos(4 * M_PI * w);
+
+            taps[tap] = sinc * window;
+            sum += taps[tap];
+        }
+
+        // Normalise each phase to unity gain so that DC doesn't ripple with the phase.
+        for(u32 tap = 0; tap < RESAMPLER_TAPS; tap++) {
+            coefs[phase][tap] = (s16) lround(taps[tap] / sum * ((1 << RESAMPLER_COEF_BITS) - 1));
+        }
+    }
+
+    resamplerReset();
+}
+
+void resamplerReset() {
+    memset(historyLeft, 0, sizeof(historyLeft));
+    memset(historyRight, 0, sizeof(historyRight));
+
+    // Start with a silent history so output begins immediately.
+    historyLength = RESAMPLER_TAPS - 1;
+    position = 0;
+}
+
+bool resamplerIsActive() {
+    return active;
+}
+
+static long resamplerAppend(const u32* in, long inSamples) {
+    long count = RESAMPLER_HISTORY - historyLength;
+    if(count > inSamples) {
+        count = inSamples;
+    }
+
+    const s16* src = (const s16*) in;
+    for(long i = 0; i < count; i++) {
+        historyLeft[historyLength + i] = src[i * 2];
+        historyRight[historyLength + i] = src[i * 2 + 1];
+    }
+
+    historyLength += count;
+    return count;
+}
+
+static void resamplerDiscard() {
+    u32 consumed = (u32) (position >> 32);
+    if(consumed > historyLength) {
+        consumed = historyLength;
+    }
+
+    memmove(historyLeft, &historyLeft[consumed], (historyLength - consumed) * sizeof(s16));
+    memmove(historyRight, &historyRight[consumed], (historyLength - consumed) * sizeof(s16));
+
+    historyLength -= consumed;
+    position -= (u64) consumed << 32;
+}
+
+#if SIMD_SSE2
+
+static inline u32 resamplerFilter(const s16* left, const s16* right, const s16* coef) {
+    __m128i leftSum = _mm_setzero_si128();
+    __m128i rightSum = _mm_setzero_si128();
+    for(u32 tap = 0; tap < RESAMPLER_TAPS; tap += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*) &coef[tap]);
+        leftSum = _mm_add_epi32(leftSum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*) &left[tap]), c));
+        rightSum = _mm_add_epi32(rightSum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*) &right[tap]), c));
+    }
+
+    // Horizontal sums; lane 0 ends up with left and lane 1 with right.
+    __m128i sums = _mm_add_epi32(_mm_unpacklo_epi32(leftSum, rightSum), _mm_unpackhi_epi32(leftSum, rightSum));
+    sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 8));
+    sums = _mm_srai_epi32(sums, RESAMPLER_COEF_BITS);
+    return (u32) _mm_cvtsi128_si32(_mm_packs_epi32(sums, sums));
+}
+
+#elif SIMD_NEON
+
+static inline u32 resamplerFilter(const s16* left, const s16* right, const s16* coef) {
+    int32x4_t leftSum = vdupq_n_s32(0);
+    int32x4_t rightSum = vdupq_n_s32(0);
+    for(u32 tap = 0; tap < RESAMPLER_TAPS; tap += 4) {
+        int16x4_t c = vld1_s16(&coef[tap]);
+        leftSum = vmlal_s16(leftSum, vld1_s16(&left[tap]), c);
+        rightSum = vmlal_s16(rightSum, vld1_s16(&right[tap]), c);
+    }
+
+    // Pairwise sums; lane 0 ends up with left and lane 1 with right.
+    int32x2_t sums = vpadd_s32(vpadd_s32(vget_low_s32(leftSum), vget_high_s32(leftSum)), vpadd_s32(vget_low_s32(rightSum), vget_high_s32(rightSum)));
+    int16x4_t samples = vqmovn_s32(vcombine_s32(vshr_n_s32(sums, RESAMPLER_COEF_BITS), vdup_n_s32(0)));
+    return vget_lane_u32(vreinterpret_u32_s16(samples), 0);
+}
+
+#else
+
+static inline s16 resamplerClamp(s32 sample) {
+    sample >>= RESAMPLER_COEF_BITS;
+    if(sample > 0x7FFF) {
+        return 0x7FFF;
+    } else if(sample < -0x8000) {
+        return -0x8000;
+    }
+
+    return (s16) sample;
+}
+
+static inline u32 resamplerFilter(const s16* left, const s16* right, const s16* coef) {
+    s32 leftSum = 0;
+    s32 rightSum = 0;
+    for(u32 tap = 0; tap < RESAMPLER_TAPS; tap++) {
+        leftSum += left[tap] * coef[tap];
+        rightSum += right[tap] * coef[tap];
+    }
+
+    return (u16) resamplerClamp(leftSum) | ((u32) (u16) resamplerClamp(rightSum) << 16);
+}
+
+#endif
+
+long resamplerProcess(const u32* in, long inSamples, u32* out, long maxOut) {
+    long written = 0;
+
+    do {
+        long appended = resamplerAppend(in, inSamples);
+        in += appended;
+        inSamples -= appended;
+
+        while(written < maxOut && (position >> 32) + RESAMPLER_TAPS <= historyLength) {
+            u32 index = (u32) (position >> 32);
+            const s16* coef = coefs[(u32) position >> (32 - RESAMPLER_PHASE_BITS)];
+
+            out[written++] = resamplerFilter(&historyLeft[index], &historyRight[index], coef);
+            position += step;
+        }
+
+        resamplerDiscard();
+    } while(inSamples > 0 && written < maxOut);
+
+    return written;
+}
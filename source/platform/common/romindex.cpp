@@ -0,0 +1,385 @@
+#include <sys/stat.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "platform/common/romindex.h"
+#include "ppu.h"
+
+// ROMs are indexed on a worker thread: only the cartridge header is parsed, and the CRC32 is
+// computed while streaming the file through a small buffer, so nothing is ever fully loaded.
+
+#define INDEX_FILE "gameyob.idx"
+
+#define INDEX_MAGIC "GYRI"
+#define INDEX_VERSION 1
+
+#define INDEX_HEADER_END 0x150
+#define INDEX_READ_SIZE 0x4000
+
+#define THUMBNAIL_SCALE (GB_SCREEN_WIDTH / ROM_INDEX_THUMBNAIL_WIDTH)
+#define THUMBNAIL_PIXELS (ROM_INDEX_THUMBNAIL_WIDTH * ROM_INDEX_THUMBNAIL_HEIGHT)
+
+typedef struct {
+    u32 size;
+    s64 mtime;
+    RomIndexEntry entry;
+} RomIndexRecord;
+
+static std::mutex indexMutex;
+static std::unordered_map<std::string, RomIndexRecord> records;
+static std::unordered_map<std::string, std::vector<u32>> pendingThumbnails;
+static bool dirty = false;
+static u32 version = 0;
+
+static std::thread worker;
+static std::condition_variable queueCond;
+static std::deque<std::string> queue;
+static bool stopRequested = false;
+
+static u32 crcTable[0x100];
+
+static void romIndexInitCRC() {
+    for(u32 i = 0; i < 0x100; i++) {
+        u32 crc = i;
+        for(u32 bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+
+        crcTable[i] = crc;
+    }
+}
+
+static u32 romIndexUpdateCRC(u32 crc, const u8* data, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+static bool romIndexReadRom(const std::string& path, RomIndexEntry* entry) {
+    std::ifstream stream(path, std::ios::binary);
+    if(!stream.is_open()) {
+        return false;
+    }
+
+    u8 buffer[INDEX_READ_SIZE];
+
+    stream.read((char*) buffer, sizeof(buffer));
+    size_t read = (size_t) stream.gcount();
+    if(read < INDEX_HEADER_END) {
+        return false;
+    }
+
+    // Same rules as the cartridge: the last title byte doubles as the CGB flag on newer games.
+    u8 cgbFlag = buffer[0x0143];
+    std::string title((const char*) &buffer[0x0134], cgbFlag == 0x80 || cgbFlag == 0xC0 ? 15 : 16);
+    title.erase(title.find_last_not_of('\0') + 1);
+
+    entry->title = title;
+    entry->cgbFlag = cgbFlag;
+    entry->sgbFlag = buffer[0x0146];
+    entry->rawMBC = buffer[0x0147];
+    entry->rawRomSize = buffer[0x0148];
+    entry->rawRamSize = buffer[0x0149];
+
+    u32 crc = 0xFFFFFFFF;
+    while(read > 0) {
+        crc = romIndexUpdateCRC(crc, buffer, read);
+
+        stream.read((char*) buffer, sizeof(buffer));
+        read = (size_t) stream.gcount();
+    }
+
+    entry->crc32 = ~crc;
+    return true;
+}
+
+static void romIndexProcess(const std::string& path) {
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+
+        auto it = records.find(path);
+        if(it != records.end() && it->second.size == (u32) st.st_size && it->second.mtime == (s64) st.st_mtime) {
+            return;
+        }
+    }
+
+    RomIndexRecord record;
+    record.size = (u32) st.st_size;
+    record.mtime = (s64) st.st_mtime;
+    if(!romIndexReadRom(path, &record.entry)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    auto old = records.find(path);
+    if(old != records.end() && old->second.entry.crc32 == record.entry.crc32) {
+        record.entry.thumbnail = std::move(old->second.entry.thumbnail);
+    }
+
+    auto pending = pendingThumbnails.find(path);
+    if(pending != pendingThumbnails.end()) {
+        record.entry.thumbnail = std::move(pending->second);
+        pendingThumbnails.erase(pending);
+    }
+
+    records[path] = std::move(record);
+    dirty = true;
+    version++;
+}
+
+static void romIndexRun() {
+    std::unique_lock<std::mutex> lock(indexMutex);
+
+    while(true) {
+        queueCond.wait(lock, [] { return stopRequested || !queue.empty(); });
+        if(stopRequested) {
+            break;
+        }
+
+        std::string path = queue.front();
+        queue.pop_front();
+
+        lock.unlock();
+        romIndexProcess(path);
+        lock.lock();
+    }
+}
+
+static void romIndexStop() {
+    if(worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            stopRequested = true;
+            queue.clear();
+        }
+
+        queueCond.notify_one();
+        worker.join();
+    }
+
+    stopRequested = false;
+}
+
+template<typename T>
+static bool romIndexReadValue(std::istream& stream, T* value) {
+    stream.read((char*) value, sizeof(T));
+    return stream.good();
+}
+
+template<typename T>
+static void romIndexWriteValue(std::ostream& stream, const T& value) {
+    stream.write((const char*) &value, sizeof(T));
+}
+
+static bool romIndexReadString(std::istream& stream, std::string* str) {
+    u16 length = 0;
+    if(!romIndexReadValue(stream, &length)) {
+        return false;
+    }
+
+    str->resize(length);
+    stream.read(&(*str)[0], length);
+    return stream.good();
+}
+
+static void romIndexWriteString(std::ostream& stream, const std::string& str) {
+    romIndexWriteValue(stream, (u16) str.length());
+    stream.write(str.data(), str.length());
+}
+
+void romIndexLoad() {
+    romIndexStop();
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    records.clear();
+    pendingThumbnails.clear();
+    dirty = false;
+    version++;
+
+    std::ifstream stream(INDEX_FILE, std::ios::binary);
+    if(!stream.is_open()) {
+        return;
+    }
+
+    char magic[4] = {0};
+    u8 fileVersion = 0;
+    u32 count = 0;
+
+    stream.read(magic, sizeof(magic));
+    if(memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 || !romIndexReadValue(stream, &fileVersion) || fileVersion != INDEX_VERSION || !romIndexReadValue(stream, &count)) {
+        return;
+    }
+
+    for(u32 i = 0; i < count; i++) {
+        std::string path;
+        RomIndexRecord record;
+        u8 hasThumbnail = 0;
+
+        if(!romIndexReadString(stream, &path)
+           || !romIndexReadValue(stream, &record.size)
+           || !romIndexReadValue(stream, &record.mtime)
+           || !romIndexReadString(stream, &record.entry.title)
+           || !romIndexReadValue(stream, &record.entry.cgbFlag)
+           || !romIndexReadValue(stream, &record.entry.sgbFlag)
+           || !romIndexReadValue(stream, &record.entry.rawMBC)
+           || !romIndexReadValue(stream, &record.entry.rawRomSize)
+           || !romIndexReadValue(stream, &record.entry.rawRamSize)
+           || !romIndexReadValue(stream, &record.entry.crc32)
+           || !romIndexReadValue(stream, &hasThumbnail)) {
+            break;
+        }
+
+        if(hasThumbnail) {
+            record.entry.thumbnail.resize(THUMBNAIL_PIXELS);
+            stream.read((char*) record.entry.thumbnail.data(), THUMBNAIL_PIXELS * sizeof(u32));
+            if(!stream.good()) {
+                break;
+            }
+        }
+
+        records[path] = std::move(record);
+    }
+}
+
+void romIndexSave() {
+    romIndexStop();
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    if(!dirty) {
+        return;
+    }
+
+    std::ofstream stream(INDEX_FILE, std::ios::binary | std::ios::trunc);
+    if(!stream.is_open()) {
+        return;
+    }
+
+    stream.write(INDEX_MAGIC, 4);
+    romIndexWriteValue(stream, (u8) INDEX_VERSION);
+    romIndexWriteValue(stream, (u32) records.size());
+
+    for(const auto& it : records) {
+        const RomIndexRecord& record = it.second;
+
+        romIndexWriteString(stream, it.first);
+        romIndexWriteValue(stream, record.size);
+        romIndexWriteValue(stream, record.mtime);
+        romIndexWriteString(stream, record.entry.title);
+        romIndexWriteValue(stream, record.entry.cgbFlag);
+        romIndexWriteValue(stream, record.entry.sgbFlag);
+        romIndexWriteValue(stream, record.entry.rawMBC);
+        romIndexWriteValue(stream, record.entry.rawRomSize);
+        romIndexWriteValue(stream, record.entry.rawRamSize);
+        romIndexWriteValue(stream, record.entry.crc32);
+
+        bool hasThumbnail = record.entry.thumbnail.size() == THUMBNAIL_PIXELS;
+        romIndexWriteValue(stream, (u8) hasThumbnail);
+        if(hasThumbnail) {
+            stream.write((const char*) record.entry.thumbnail.data(), THUMBNAIL_PIXELS * sizeof(u32));
+        }
+    }
+
+    if(stream.good()) {
+        dirty = false;
+    }
+}
+
+void romIndexQueue(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        queue.push_back(path);
+    }
+
+    if(!worker.joinable()) {
+        if(crcTable[1] == 0) {
+            romIndexInitCRC();
+        }
+
+        worker = std::thread(romIndexRun);
+    }
+
+    queueCond.notify_one();
+}
+
+bool romIndexLookup(const std::string& path, RomIndexEntry* entry) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    auto it = records.find(path);
+    if(it == records.end()) {
+        return false;
+    }
+
+    if(entry != nullptr) {
+        *entry = it->second.entry;
+    }
+
+    return true;
+}
+
+void romIndexSetThumbnail(const std::string& path, const u32* frame, u32 pitch) {
+    std::vector<u32> thumbnail(THUMBNAIL_PIXELS);
+
+    // Average each block of pixels one byte at a time, so this works for any 8-bit-per-channel layout.
+    for(u32 y = 0; y < ROM_INDEX_THUMBNAIL_HEIGHT; y++) {
+        for(u32 x = 0; x < ROM_INDEX_THUMBNAIL_WIDTH; x++) {
+            u32 sums[4] = {0, 0, 0, 0};
+            for(u32 sy = 0; sy < THUMBNAIL_SCALE; sy++) {
+                const u32* row = &frame[(GB_SCREEN_Y + y * THUMBNAIL_SCALE + sy) * pitch + GB_SCREEN_X + x * THUMBNAIL_SCALE];
+                for(u32 sx = 0; sx < THUMBNAIL_SCALE; sx++) {
+                    for(u32 b = 0; b < 4; b++) {
+                        sums[b] += (row[sx] >> (b * 8)) & 0xFF;
+                    }
+                }
+            }
+
+            u32 pixel = 0;
+            for(u32 b = 0; b < 4; b++) {
+                pixel |= (sums[b] / (THUMBNAIL_SCALE * THUMBNAIL_SCALE)) << (b * 8);
+            }
+
+            thumbnail[y * ROM_INDEX_THUMBNAIL_WIDTH + x] = pixel;
+        }
+    }
+
+    bool indexed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+
+        auto it = records.find(path);
+        if(it != records.end()) {
+            it->second.entry.thumbnail = std::move(thumbnail);
+            dirty = true;
+            version++;
+
+            indexed = true;
+        } else {
+            pendingThumbnails[path] = std::move(thumbnail);
+        }
+    }
+
+    if(!indexed) {
+        romIndexQueue(path);
+    }
+}
+
+u32 romIndexGetVersion() {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return version;
+}
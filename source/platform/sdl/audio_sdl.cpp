@@ -1,29 +1,139 @@
 #ifdef BACKEND_SDL
 
+#include <atomic>
+
 #include <SDL2/SDL.h>
 
+#include "platform/common/config.h"
 #include "platform/common/manager.h"
+#include "platform/common/resampler.h"
 #include "platform/audio.h"
 #include "platform/gfx.h"
 
+// Must be a power of two, and hold MAX_FRAMES at the highest output rate.
+#define RING_SAMPLES 16384
+#define RING_MASK (RING_SAMPLES - 1)
+
+// Aim to keep about two frames of audio queued, and never more than six.
+#define TARGET_FRAMES 2
+#define MAX_FRAMES 6
+
+// Used when the device can't be opened, so that emulation still has a rate to run at.
+#define FALLBACK_SAMPLE_RATE 44100
+
+// The highest output rate. Devices that natively run faster are opened at this rate instead,
+// and SDL converts; the ring and the manager's audio buffer are only sized for this much.
+#define MAX_SAMPLE_RATE 96000
+
+#define MAX_RATE_ADJUST 0.005
+#define FILL_SMOOTHING 0.05
+
 static bool initialized = false;
 
 static SDL_AudioDeviceID device;
 
+static u32 deviceRate;
+// Non-zero when the APU synthesises at a fixed rate which is resampled to the device's.
+static u32 internalRate;
+static u32 resampled[RING_SAMPLES];
+
+// Single-producer, single-consumer ring. The emulator thread only advances the write
+// position, and the audio callback only advances the read position.
+static u32 ring[RING_SAMPLES];
+static std::atomic<u32> ringRead;
+static std::atomic<u32> ringWrite;
+static u32 lastSample;
+
+static u32 samplesPerFrame;
+static double averageFill;
+static double rateScale;
+
+static void audioCallback(void* userdata, Uint8* stream, int len) {
+    u32* out = (u32*) stream;
+    u32 samples = (u32) len / sizeof(u32);
+
+    u32 read = ringRead.load(std::memory_order_relaxed);
+    u32 avail = ringWrite.load(std::memory_order_acquire) - read;
+
+    u32 count = samples < avail ? samples : avail;
+    for(u32 i = 0; i < count; i++) {
+        out[i] = ring[(read + i) & RING_MASK];
+    }
+
+    if(count > 0) {
+        lastSample = out[count - 1];
+    }
+
+    // Hold the last sample on underrun rather than dropping to silence, which clicks.
+    for(u32 i = count; i < samples; i++) {
+        out[i] = lastSample;
+    }
+
+    ringRead.store(read + count, std::memory_order_release);
+}
+
+static u32 audioGetFill() {
+    return ringWrite.load(std::memory_order_relaxed) - ringRead.load(std::memory_order_acquire);
+}
+
+static u32 audioGetConfiguredRate(u8 option) {
+    switch(configGetMultiChoice(GROUP_SOUND, option)) {
+        case SAMPLE_RATE_32768:
+            return 32768;
+        case SAMPLE_RATE_44100:
+            return 44100;
+        case SAMPLE_RATE_48000:
+            return 48000;
+        case SAMPLE_RATE_96000:
+            return 96000;
+        default:
+            return 0;
+    }
+}
+
 void audioInit() {
+    ringRead = 0;
+    ringWrite = 0;
+    lastSample = 0;
+
+    deviceRate = 0;
+    internalRate = 0;
+    rateScale = 1;
+
+    // With no rate configured, let SDL give us whatever the device runs at natively.
+    u32 outputRate = audioGetConfiguredRate(SOUND_OUTPUT_RATE);
+
     SDL_AudioSpec as;
-    as.freq = (int) audioGetSampleRate();
+    as.freq = outputRate != 0 ? (int) outputRate : 48000;
     as.format = AUDIO_S16SYS;
     as.channels = 2;
     as.silence = 0;
-    as.samples = 2048;
+    as.samples = 512;
     as.size = 0;
-    as.callback = nullptr;
+    as.callback = audioCallback;
     as.userdata = nullptr;
-    if((device = SDL_OpenAudioDevice(nullptr, 0, &as, &as, 0)) < 0) {
+
+    SDL_AudioSpec obtained;
+    if((device = SDL_OpenAudioDevice(nullptr, 0, &as, &obtained, outputRate != 0 ? 0 : SDL_AUDIO_ALLOW_FREQUENCY_CHANGE)) == 0) {
         return;
     }
 
+    if(obtained.freq > MAX_SAMPLE_RATE) {
+        SDL_CloseAudioDevice(device);
+
+        as.freq = MAX_SAMPLE_RATE;
+        if((device = SDL_OpenAudioDevice(nullptr, 0, &as, &obtained, 0)) == 0) {
+            return;
+        }
+    }
+
+    deviceRate = (u32) obtained.freq;
+    internalRate = audioGetConfiguredRate(SOUND_INTERNAL_RATE);
+    resamplerInit(internalRate, deviceRate);
+
+    samplesPerFrame = (u32) (deviceRate / 59.7);
+    averageFill = samplesPerFrame * TARGET_FRAMES;
+
     SDL_PauseAudioDevice(device, false);
 
     initialized = true;
@@ -40,7 +150,32 @@ void audioCleanup() {
 }
 
 u32 audioGetSampleRate() {
-    return 44100;
+    if(internalRate != 0) {
+        return internalRate;
+    }
+
+    return deviceRate != 0 ? deviceRate : FALLBACK_SAMPLE_RATE;
+}
+
+double audioGetRateScale() {
+    return rateScale;
+}
+
+bool audioWaitForFrame() {
+    if(!initialized) {
+        return false;
+    }
+
+    u32 targetFill = samplesPerFrame * TARGET_FRAMES;
+    while(audioGetFill() > targetFill) {
+        if(SDL_GetAudioDeviceStatus(device) != SDL_AUDIO_PLAYING) {
+            return false;
+        }
+
+        SDL_Delay(1);
+    }
+
+    return true;
 }
 
 void audioPlay(u32* buffer, long samples) {
@@ -48,12 +183,47 @@ void audioPlay(u32* buffer, long samples) {
         return;
     }
 
-    // If we're fast-forwarding or not going fast enough, clear the audio queue to prevent build-up.
-    if(mgrGetFastForward() || SDL_GetQueuedAudioSize(device) >= (u32) ((audioGetSampleRate() / 59.7) * 10) * sizeof(u32)) {
-        SDL_ClearQueuedAudio(device);
+    if(resamplerIsActive()) {
+        samples = resamplerProcess(buffer, samples, resampled, RING_SAMPLES);
+        buffer = resampled;
+    }
+
+    u32 maxFill = samplesPerFrame * MAX_FRAMES;
+
+    if(!mgrGetFastForward()) {
+        // Producing faster than the device plays; let the audio clock hold us back.
+        while(audioGetFill() + samples > maxFill && SDL_GetAudioDeviceStatus(device) == SDL_AUDIO_PLAYING) {
+            SDL_Delay(1);
+        }
+    }
+
+    u32 fill = audioGetFill();
+    u32 space = fill < maxFill ? maxFill - fill : 0;
+    if((u32) samples > space) {
+        // Only reached while fast-forwarding; drop what doesn't fit instead of building up latency.
+        samples = space;
+    }
+
+    u32 write = ringWrite.load(std::memory_order_relaxed);
+    for(long i = 0; i < samples; i++) {
+        ring[(write + i) & RING_MASK] = buffer[i];
+    }
+
+    ringWrite.store(write + (u32) samples, std::memory_order_release);
+
+    // Nudge the APU's output rate to keep the queue near its target. A fuller queue
+    // means a faster clock rate, which produces fewer samples per frame.
+    averageFill += (audioGetFill() - averageFill) * FILL_SMOOTHING;
+
+    double target = samplesPerFrame * TARGET_FRAMES;
+    double error = (averageFill - target) / target;
+    if(error > 1) {
+        error = 1;
+    } else if(error < -1) {
+        error = -1;
     }
 
-    SDL_QueueAudio(device, buffer, samples * sizeof(u32));
+    rateScale = 1 + error * MAX_RATE_ADJUST;
 }
 
-#endif
\ No newline at end of file
+#endif
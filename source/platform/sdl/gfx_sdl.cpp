@@ -147,4 +147,12 @@ void gfxDrawScreen() {
     SDL_RenderPresent(renderer);
 }
 
+bool gfxSetVsync(bool vsync) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    return renderer != nullptr && SDL_RenderSetVSync(renderer, vsync ? 1 : 0) == 0;
+#else
+    return false;
+#endif
+}
+
 #endif
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include "platform/input.h"
 
 #include <SDL2/SDL_events.h>
+#include <SDL2/SDL_gamecontroller.h>
+
+#define STICK_THRESHOLD 16384
 
 static KeyConfig defaultKeyConfig = {
         "Main",
@@ -22,6 +25,45 @@ static bool forceReleased[NUM_FUNC_KEYS] = {false};
 static const Uint8* keyState = nullptr;
 static u32 keyCount = 0;
 
+static SDL_GameController* controllers[INPUT_MAX_PLAYERS - 1] = {nullptr};
+static u32 controllerHeld[INPUT_MAX_PLAYERS - 1] = {0};
+
+static const struct {
+    SDL_GameControllerButton button;
+    u32 funcKey;
+} controllerMapping[] = {
+        {SDL_CONTROLLER_BUTTON_A, FUNC_KEY_A},
+        {SDL_CONTROLLER_BUTTON_B, FUNC_KEY_B},
+        {SDL_CONTROLLER_BUTTON_START, FUNC_KEY_START},
+        {SDL_CONTROLLER_BUTTON_BACK, FUNC_KEY_SELECT},
+        {SDL_CONTROLLER_BUTTON_DPAD_LEFT, FUNC_KEY_LEFT},
+        {SDL_CONTROLLER_BUTTON_DPAD_RIGHT, FUNC_KEY_RIGHT},
+        {SDL_CONTROLLER_BUTTON_DPAD_UP, FUNC_KEY_UP},
+        {SDL_CONTROLLER_BUTTON_DPAD_DOWN, FUNC_KEY_DOWN}
+};
+
+// Called on controller hotplug events; extra players are assigned in device order.
+void inputRefreshControllers() {
+    for(u32 i = 0; i < INPUT_MAX_PLAYERS - 1; i++) {
+        if(controllers[i] != nullptr) {
+            SDL_GameControllerClose(controllers[i]);
+            controllers[i] = nullptr;
+        }
+
+        controllerHeld[i] = 0;
+    }
+
+    u32 player = 0;
+    for(int i = 0; i < SDL_NumJoysticks() && player < INPUT_MAX_PLAYERS - 1; i++) {
+        if(SDL_IsGameController(i)) {
+            controllers[player] = SDL_GameControllerOpen(i);
+            if(controllers[player] != nullptr) {
+                player++;
+            }
+        }
+    }
+}
+
 void inputInit() {
     int count = 0;
     keyState = SDL_GetKeyboardState(&count);
@@ -44,9 +86,17 @@ void inputInit() {
     defaultKeyConfig.funcKeys[SDL_SCANCODE_LALT] = FUNC_KEY_FAST_FORWARD_TOGGLE;
     defaultKeyConfig.funcKeys[SDL_SCANCODE_RCTRL] = FUNC_KEY_SCALE;
     defaultKeyConfig.funcKeys[SDL_SCANCODE_RALT] = FUNC_KEY_RESET;
+
+    inputRefreshControllers();
 }
 
 void inputCleanup() {
+    for(u32 i = 0; i < INPUT_MAX_PLAYERS - 1; i++) {
+        if(controllers[i] != nullptr) {
+            SDL_GameControllerClose(controllers[i]);
+            controllers[i] = nullptr;
+        }
+    }
 }
 
 void inputUpdate() {
@@ -68,6 +118,36 @@ void inputUpdate() {
             forceReleased[funcKey] = false;
         }
     }
+
+    for(u32 i = 0; i < INPUT_MAX_PLAYERS - 1; i++) {
+        SDL_GameController* controller = controllers[i];
+        if(controller == nullptr) {
+            continue;
+        }
+
+        u32 currHeld = 0;
+        for(const auto& mapping : controllerMapping) {
+            if(SDL_GameControllerGetButton(controller, mapping.button)) {
+                currHeld |= 1U << mapping.funcKey;
+            }
+        }
+
+        s16 axisX = SDL_GameControllerGetAxis(controller, SDL_CONTROLLER_AXIS_LEFTX);
+        s16 axisY = SDL_GameControllerGetAxis(controller, SDL_CONTROLLER_AXIS_LEFTY);
+        if(axisX < -STICK_THRESHOLD) {
+            currHeld |= 1U << FUNC_KEY_LEFT;
+        } else if(axisX > STICK_THRESHOLD) {
+            currHeld |= 1U << FUNC_KEY_RIGHT;
+        }
+
+        if(axisY < -STICK_THRESHOLD) {
+            currHeld |= 1U << FUNC_KEY_UP;
+        } else if(axisY > STICK_THRESHOLD) {
+            currHeld |= 1U << FUNC_KEY_DOWN;
+        }
+
+        controllerHeld[i] = currHeld;
+    }
 }
 
 bool inputKeyHeld(u32 key) {
@@ -84,6 +164,14 @@ void inputReleaseAll() {
     }
 }
 
+bool inputPlayerKeyHeld(u32 player, u32 key) {
+    if(player == 0) {
+        return inputKeyHeld(key);
+    }
+
+    return player < INPUT_MAX_PLAYERS && key < NUM_FUNC_KEYS && (controllerHeld[player - 1] & (1U << key)) != 0;
+}
+
 void inputGetMotionSensor(u16* x, u16* y) {
     *x = 0x7FF;
     *y = 0x7FF;
@@ -2,6 +2,7 @@
 
 #include <SDL2/SDL.h>
 
+#include "platform/common/camera.h"
 #include "platform/audio.h"
 #include "platform/input.h"
 #include "platform/gfx.h"
@@ -9,11 +10,12 @@
 #include "platform/ui.h"
 
 extern void gfxUpdateWindow();
+extern void inputRefreshControllers();
 
 static bool requestedExit;
 
 bool systemInit(int argc, char* argv[]) {
-    if(SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO) != 0 || !gfxInit()) {
+    if(SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) != 0 || !gfxInit()) {
         return false;
     }
 
@@ -47,6 +49,8 @@ bool systemIsRunning() {
             return false;
         } else if(event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
             gfxUpdateWindow();
+        } else if(event.type == SDL_CONTROLLERDEVICEADDED || event.type == SDL_CONTROLLERDEVICEREMOVED) {
+            inputRefreshControllers();
         }
     }
 
@@ -58,7 +62,7 @@ void systemRequestExit() {
 }
 
 u32* systemGetCameraImage() {
-    return nullptr;
+    return cameraGetImage();
 }
 
 #endif
\ No newline at end of file
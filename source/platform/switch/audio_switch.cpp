@@ -53,6 +53,14 @@ u32 audioGetSampleRate() {
     return audoutGetSampleRate();
 }
 
+double audioGetRateScale() {
+    return 1;
+}
+
+bool audioWaitForFrame() {
+    return false;
+}
+
 void audioPlay(u32* buffer, long samples) {
     long remaining = samples;
     while(remaining > 0) {
@@ -191,4 +191,8 @@ void gfxDrawScreen() {
     }
 }
 
+bool gfxSetVsync(bool vsync) {
+    return false;
+}
+
 #endif
@@ -107,6 +107,8 @@ static UIKey uiKeyMapping[NUM_BUTTONS] = {
 
 static u64 funcKeyMapping[NUM_FUNC_KEYS];
 
+static u64 playerHeld[INPUT_MAX_PLAYERS - 1] = {0};
+
 static bool forceReleased[NUM_FUNC_KEYS] = {false};
 static bool uiForceReleased[NUM_BUTTONS] = {false};
 
@@ -127,6 +129,11 @@ void inputUpdate() {
     u64 down = hidKeysDown(CONTROLLER_P1_AUTO);
     u64 held = hidKeysHeld(CONTROLLER_P1_AUTO);
 
+    for(u32 i = 0; i < INPUT_MAX_PLAYERS - 1; i++) {
+        HidControllerID id = (HidControllerID) (CONTROLLER_PLAYER_2 + i);
+        playerHeld[i] = hidIsControllerConnected(id) ? hidKeysHeld(id) : 0;
+    }
+
     for(u32 i = 0; i < NUM_FUNC_KEYS; i++) {
         if(!(held & funcKeyMapping[i])) {
             forceReleased[i] = false;
@@ -185,6 +192,14 @@ void inputReleaseAll() {
     }
 }
 
+bool inputPlayerKeyHeld(u32 player, u32 key) {
+    if(player == 0) {
+        return inputKeyHeld(key);
+    }
+
+    return player < INPUT_MAX_PLAYERS && key < NUM_FUNC_KEYS && (playerHeld[player - 1] & funcKeyMapping[key]) != 0;
+}
+
 void inputGetMotionSensor(u16* x, u16* y) {
     // TODO
     *x = 0x7FF;
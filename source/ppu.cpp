@@ -90,6 +90,7 @@ void PPU::reset() {
     memset(this->oam, 0, sizeof(this->oam));
     memset(this->rawBgPalette, 0, sizeof(this->rawBgPalette));
     memset(this->rawSprPalette, 0, sizeof(this->rawSprPalette));
+    memset(this->linePalettes, 0, sizeof(this->linePalettes));
 
     if(this->gameboy->gbMode == MODE_CGB) {
         memset(this->bgPalette, 0xFF, sizeof(this->bgPalette));
@@ -673,11 +674,25 @@ inline void PPU::updateScanline() {
     }
 }
 
+inline void PPU::loadLinePalettes(u8 scanline) {
+    if(this->gameboy->gbMode == MODE_SGB) {
+        u8 count = 0;
+        const SgbPaletteRun* runs = this->gameboy->sgb.getPaletteRuns(scanline, &count);
+        for(u8 i = 0; i < count; i++) {
+            memset(&this->linePalettes[runs[i].x], runs[i].palette, runs[i].width);
+        }
+    }
+}
+
 inline void PPU::drawPixel(u8 x, u8 y) {
     if(this->gameboy->settings.frameBuffer == nullptr) {
         return;
     }
 
+    if(x == 0) {
+        this->loadLinePalettes(y);
+    }
+
     u32* colorOut = &this->gameboy->settings.frameBuffer[(y + GB_SCREEN_Y) * this->gameboy->settings.framePitch + (x + GB_SCREEN_X)];
     bool emulateBlur = this->gameboy->settings.getOption(GB_OPT_EMULATE_BLUR);
 
@@ -703,7 +718,7 @@ inline void PPU::drawPixel(u8 x, u8 y) {
                         this->updateLineTile(map, pixelX, pixelY);
                     }
 
-                    u8 palette = this->gameboy->gbMode == MODE_SGB ? this->gameboy->sgb.getPaletteMap()[(y >> 3) * 20 + (x >> 3)] : line->palette;
+                    u8 palette = line->palette + this->linePalettes[x];
 
                     colorDst = baseBgPalette[(palette << 2) + this->expandedBgp[line->color[subX]]];
                     depthDst = line->depth[subX];
@@ -724,7 +739,7 @@ inline void PPU::drawPixel(u8 x, u8 y) {
                             this->updateLineTile(map, pixelX, pixelY);
                         }
 
-                        u8 palette = this->gameboy->gbMode == MODE_SGB ? this->gameboy->sgb.getPaletteMap()[(y >> 3) * 20 + (x >> 3)] : line->palette;
+                        u8 palette = line->palette + this->linePalettes[x];
 
                         colorDst = baseBgPalette[(palette << 2) + this->expandedBgp[line->color[subX]]];
                         depthDst = line->depth[subX];
@@ -741,10 +756,7 @@ inline void PPU::drawPixel(u8 x, u8 y) {
                             continue;
                         }
 
-                        u8 palette = line->palette;
-                        if(this->gameboy->gbMode == MODE_SGB) {
-                            palette += this->gameboy->sgb.getPaletteMap()[(y >> 3) * 20 + (x >> 3)];
-                        }
+                        u8 palette = line->palette + this->linePalettes[x];
 
                         u8 color = line->color[subX];
                         u8 depth = line->depth[subX];
@@ -785,6 +797,8 @@ inline void PPU::drawScanline(u8 scanline) {
     u32* lineBuffer = &this->gameboy->settings.frameBuffer[(scanline + GB_SCREEN_Y) * this->gameboy->settings.framePitch + GB_SCREEN_X];
     bool emulateBlur = this->gameboy->settings.getOption(GB_OPT_EMULATE_BLUR);
 
+    this->loadLinePalettes(scanline);
+
     switch(this->gameboy->sgb.getGfxMask()) {
         case 0: {
             u8 lcdc = this->gameboy->mmu.readIO(LCDC);
@@ -794,8 +808,6 @@ inline void PPU::drawScanline(u8 scanline) {
                 u32* baseBgPalette = this->gameboy->gbMode != MODE_GB || !this->gameboy->mmu.isBiosMapped() ? (u32*) this->bgPalette : grayScalePalette;
                 u32* baseSprPalette = this->gameboy->gbMode != MODE_GB || !this->gameboy->mmu.isBiosMapped() ? (u32*) this->sprPalette : grayScalePalette;
 
-                u8* subSgbMap = &this->gameboy->sgb.getPaletteMap()[(scanline >> 3) * 20];
-
                 // Background
                 if(this->gameboy->gbMode == MODE_CGB || (lcdc & 0x01) != 0) {
                     u8 basePixelX = this->gameboy->mmu.readIO(SCX);
@@ -839,7 +851,7 @@ inline void PPU::drawScanline(u8 scanline) {
                                 continue;
                             }
 
-                            u8 palette = this->gameboy->gbMode == MODE_SGB ? subSgbMap[pixelX >> 3] : paletteId;
+                            u8 palette = paletteId + this->linePalettes[pixelX];
                             u8 colorId = (u8) ((pxData >> (x << 1)) & 3);
                             depthBuffer[pixelX] = (u8) ((depth - (u8) (colorId == 0)) & 3);
 
@@ -900,7 +912,7 @@ inline void PPU::drawScanline(u8 scanline) {
                                     continue;
                                 }
 
-                                u8 palette = this->gameboy->gbMode == MODE_SGB ? subSgbMap[pixelX >> 3] : paletteId;
+                                u8 palette = paletteId + this->linePalettes[pixelX];
                                 u8 colorId = (u8) ((pxData >> (x << 1)) & 3);
                                 depthBuffer[pixelX] = (u8) ((depth - (u8) (colorId == 0)) & 3);
 
@@ -933,10 +945,7 @@ inline void PPU::drawScanline(u8 scanline) {
                             if(colorId != 0 && depth >= depthBuffer[pixelX]) {
                                 depthBuffer[pixelX] = depth;
 
-                                u8 palette = line->palette;
-                                if(this->gameboy->gbMode == MODE_SGB) {
-                                    palette += subSgbMap[pixelX >> 3];
-                                }
+                                u8 palette = line->palette + this->linePalettes[pixelX];
 
                                 u32 outputColor = baseSprPalette[(palette << 2) + this->expandedObp[(line->obp << 2) + colorId]];
                                 u32* colorOut = &lineBuffer[pixelX];
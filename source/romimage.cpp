@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <mutex>
+#include <vector>
+
+#include "cartridge.h"
+#include "romimage.h"
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+// GameBoys on separate threads may load and unload ROMs at the same time.
+static std::mutex imagesMutex;
+static std::vector<RomImage*> images;
+
+RomImage::RomImage(u8* data, u32 size, u32 rawSize, romImageFree freeFunc) {
+    this->data = data;
+    this->size = size;
+    this->rawSize = rawSize;
+
+    this->hashed = false;
+    this->hash = 0;
+
+    this->mapped = false;
+    this->fileId = {0, 0, 0};
+
+    this->refs = 1;
+    this->freeFunc = freeFunc;
+}
+
+RomImage::~RomImage() {
+    if(this->data != nullptr) {
+        if(this->freeFunc != nullptr) {
+            this->freeFunc(this->data, this->size);
+        } else {
+            delete[] this->data;
+        }
+
+        this->data = nullptr;
+    }
+}
+
+RomImage* RomImage::acquire(std::istream& romData, u32 romSize) {
+    u32 roundedSize = getRoundedSize(romSize);
+
+    u8* data = new u8[roundedSize]();
+    romData.read((char*) data, romSize);
+
+    fixup(data, romSize, roundedSize);
+    u64 hash = hashData(data, romSize);
+
+    std::lock_guard<std::mutex> lock(imagesMutex);
+
+    for(RomImage* image : images) {
+        // Different ROMs can share a hash, so only the contents decide.
+        if(image->rawSize == romSize && image->hashed && image->hash == hash && memcmp(image->data, data, roundedSize) == 0) {
+            delete[] data;
+
+            image->retain();
+            return image;
+        }
+    }
+
+    RomImage* image = new RomImage(data, roundedSize, romSize, nullptr);
+    image->hashed = true;
+    image->hash = hash;
+
+    images.push_back(image);
+    return image;
+}
+
+RomImage* RomImage::acquire(u8* romData, u32 romSize, romImageFree freeFunc, const RomFileId& fileId) {
+    std::lock_guard<std::mutex> lock(imagesMutex);
+
+    for(RomImage* image : images) {
+        if(image->mapped && image->rawSize == romSize && image->fileId.device == fileId.device && image->fileId.inode == fileId.inode && image->fileId.mtime == fileId.mtime) {
+            if(freeFunc != nullptr) {
+                freeFunc(romData, romSize);
+            }
+
+            image->retain();
+            return image;
+        }
+    }
+
+    u32 roundedSize = getRoundedSize(romSize);
+    if(roundedSize != romSize) {
+        // Pad out to a whole number of banks.
+        u8* data = new u8[roundedSize]();
+        memcpy(data, romData, romSize);
+
+        if(freeFunc != nullptr) {
+            freeFunc(romData, romSize);
+        }
+
+        romData = data;
+        freeFunc = nullptr;
+    }
+
+    fixup(romData, romSize, roundedSize);
+
+    RomImage* image = new RomImage(romData, roundedSize, romSize, freeFunc);
+    image->mapped = true;
+    image->fileId = fileId;
+
+    images.push_back(image);
+    return image;
+}
+
+u64 RomImage::getHash() {
+    std::lock_guard<std::mutex> lock(imagesMutex);
+
+    if(!this->hashed) {
+        this->hash = hashData(this->data, this->rawSize);
+        this->hashed = true;
+    }
+
+    return this->hash;
+}
+
+void RomImage::retain() {
+    this->refs++;
+}
+
+void RomImage::release() {
+    std::lock_guard<std::mutex> lock(imagesMutex);
+
+    if(--this->refs == 0) {
+        images.erase(std::remove(images.begin(), images.end(), this), images.end());
+        delete this;
+    }
+}
+
+u32 RomImage::getRoundedSize(u32 romSize) {
+    u32 banks = (romSize + ROM_BANK_SIZE - 1) >> 14;
+
+    // Round number of banks to next power of two.
+    if(banks > 0) {
+        banks--;
+        banks |= banks >> 1;
+        banks |= banks >> 2;
+        banks |= banks >> 4;
+        banks |= banks >> 8;
+        banks |= banks >> 16;
+        banks++;
+    }
+
+    if(banks < 2) {
+        banks = 2;
+    }
+
+    return banks * ROM_BANK_SIZE;
+}
+
+u64 RomImage::hashData(const u8* data, u32 size) {
+    // FNV-1a
+    u64 hash = FNV_OFFSET_BASIS;
+    for(u32 i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+void RomImage::fixup(u8* data, u32 romSize, u32 roundedSize) {
+    // Most MMM01 dumps have the initial banks at the end of the ROM rather than the beginning, so check if this is the case and compensate.
+    if(romSize > 0x8000) {
+        // Check for the logo.
+        static const u8 logo[] = {
+                0xCE, 0xED, 0x66, 0x66, 0xCC, 0x0D, 0x00, 0x0B, 0x03, 0x73, 0x00, 0x83, 0x00, 0x0C, 0x00, 0x0D,
+                0x00, 0x08, 0x11, 0x1F, 0x88, 0x89, 0x00, 0x0E, 0xDC, 0xCC, 0x6E, 0xE6, 0xDD, 0xDD, 0xD9, 0x99,
+                0xBB, 0xBB, 0x67, 0x63, 0x6E, 0x0E, 0xEC ,0xCC, 0xDD, 0xDC, 0x99, 0x9F, 0xBB, 0xB9, 0x33, 0x3E
+        };
+
+        u8* checkBank = &data[roundedSize - 0x8000];
+
+        if(memcmp(logo, &checkBank[0x0104], sizeof(logo)) == 0) {
+            // Check for MMM01.
+            u8 mbcType = checkBank[0x0147];
+
+            if(mbcType >= 0x0B && mbcType <= 0x0D) {
+                // Move the last 32KB to the front in place.
+                std::rotate(data, &data[roundedSize - 0x8000], &data[roundedSize]);
+            }
+        }
+    }
+}
@@ -8,8 +8,13 @@
 #include "printer.h"
 #include "serial.h"
 
+// Eight polls for every byte at the normal transfer rate.
+#define SERIAL_LINK_POLL_CYCLES (CYCLES_PER_SECOND / 1024 / 8)
+
 Serial::Serial(Gameboy* gameboy) : printer(gameboy) {
     this->gameboy = gameboy;
+
+    this->link = nullptr;
 }
 
 void Serial::reset() {
@@ -26,25 +31,32 @@ void Serial::update() {
         this->printer.update();
     }
 
+    if(this->link != nullptr) {
+        u64 nextCycle = this->link->sync(this->gameboy->cpu.getCycle());
+        if(nextCycle > 0) {
+            this->gameboy->cpu.setEventCycle(nextCycle);
+        }
+    }
+
     // For external clock
     if(this->nextSerialExternalCycle > 0) {
         if(this->gameboy->cpu.getCycle() >= this->nextSerialExternalCycle) {
             u8 sc = this->gameboy->mmu.readIO(SC);
 
-            u8 received = 0xFF;
-            if((sc & 0x81) == 0x80) {
-                // TODO: Receive/Send
-            }
-
-            this->gameboy->mmu.writeIO(SB, received);
+            this->nextSerialExternalCycle = 0;
 
-            if(sc & 0x80) {
-                this->gameboy->mmu.writeIO(SC, (u8) (sc & ~0x80));
+            if((sc & 0x81) == 0x80 && this->link != nullptr) {
+                u8 received = 0xFF;
+                if(this->link->poll(this->gameboy->cpu.getCycle(), this->gameboy->mmu.readIO(SB), &received)) {
+                    this->gameboy->mmu.writeIO(SB, received);
+                    this->gameboy->mmu.writeIO(SC, (u8) (sc & ~0x80));
 
-                this->gameboy->mmu.writeIO(IF, (u8) (this->gameboy->mmu.readIO(IF) | INT_SERIAL));
+                    this->gameboy->mmu.writeIO(IF, (u8) (this->gameboy->mmu.readIO(IF) | INT_SERIAL));
+                } else {
+                    this->nextSerialExternalCycle = this->gameboy->cpu.getCycle() + SERIAL_LINK_POLL_CYCLES;
+                    this->gameboy->cpu.setEventCycle(this->nextSerialExternalCycle);
+                }
             }
-
-            this->nextSerialExternalCycle = 0;
         } else {
             this->gameboy->cpu.setEventCycle(this->nextSerialExternalCycle);
         }
@@ -59,8 +71,8 @@ void Serial::update() {
             u8 received = 0xFF;
             if(printerEnabled) {
                 received = this->printer.link(sb);
-            } else {
-                // TODO: Send/Receive
+            } else if(this->link != nullptr) {
+                received = this->link->transfer(this->gameboy->cpu.getCycle(), sb);
             }
 
             this->gameboy->mmu.writeIO(SB, received);
@@ -91,10 +103,37 @@ void Serial::write(u16 addr, u8 val) {
             }
         } else {
             this->nextSerialInternalCycle = 0;
+
+            // Waiting on an external clock; keep asking the link whether a byte has been clocked in.
+            if((val & 0x81) == 0x80 && this->link != nullptr && this->nextSerialExternalCycle == 0) {
+                this->nextSerialExternalCycle = this->gameboy->cpu.getCycle() + SERIAL_LINK_POLL_CYCLES;
+                this->gameboy->cpu.setEventCycle(this->nextSerialExternalCycle);
+            }
         }
     }
 }
 
+void Serial::setLink(SerialLink* link) {
+    this->link = link;
+}
+
+u8 Serial::linkReceive(u8 val) {
+    // Only shift when waiting on an external clock; otherwise the other side reads an open line.
+    u8 sc = this->gameboy->mmu.readIO(SC);
+    if((sc & 0x81) != 0x80) {
+        return 0xFF;
+    }
+
+    u8 sb = this->gameboy->mmu.readIO(SB);
+
+    this->gameboy->mmu.writeIO(SB, val);
+    this->gameboy->mmu.writeIO(SC, (u8) (sc & ~0x80));
+
+    this->gameboy->mmu.writeIO(IF, (u8) (this->gameboy->mmu.readIO(IF) | INT_SERIAL));
+
+    return sb;
+}
+
 std::istream& operator>>(std::istream& is, Serial& serial) {
     is.read((char*) &serial.nextSerialInternalCycle, sizeof(serial.nextSerialInternalCycle));
     is.read((char*) &serial.nextSerialExternalCycle, sizeof(serial.nextSerialExternalCycle));
@@ -33,8 +33,17 @@ void SGB::reset() {
     memset(this->bgTiles, 0, sizeof(this->bgTiles));
     memset(this->bgMap, 0, sizeof(this->bgMap));
 
+    memset(this->bgPixels, 0, sizeof(this->bgPixels));
+    for(u8 palette = 0; palette < 4; palette++) {
+        this->loadBgPalette(palette);
+    }
+
+    this->bgColor0 = 0;
+    memset(this->bgDirty, 0, sizeof(this->bgDirty));
+
     this->mask = 0;
     memset(this->paletteMap, 0, sizeof(this->paletteMap));
+    this->invalidatePaletteRuns();
 }
 
 void SGB::update() {
@@ -169,8 +178,17 @@ std::istream& operator>>(std::istream& is, SGB& sgb) {
 
     is.read((char*) &sgb.mask, sizeof(sgb.mask));
     is.read((char*) sgb.paletteMap, sizeof(sgb.paletteMap));
+    sgb.invalidatePaletteRuns();
 
-    sgb.refreshBg();
+    for(u32 tile = 0; tile < 0x100; tile++) {
+        sgb.decodeBgTile((u8) tile);
+    }
+
+    for(u8 palette = 0; palette < 4; palette++) {
+        sgb.loadBgPalette(palette);
+    }
+
+    sgb.invalidateBorder();
 
     return is;
 }
@@ -201,40 +219,129 @@ std::ostream& operator<<(std::ostream& os, const SGB& sgb) {
     return os;
 }
 
+const SgbPaletteRun* SGB::getPaletteRuns(u8 scanline, u8* count) {
+    u8 row = (u8) (scanline >> 3);
+
+    if(this->paletteRowsDirty & (1U << row)) {
+        u8* rowMap = &this->paletteMap[row * SGB_MAP_WIDTH];
+        SgbPaletteRun* runs = this->paletteRuns[row];
+
+        u8 numRuns = 0;
+        for(u8 x = 0; x < SGB_MAP_WIDTH; x++) {
+            if(numRuns > 0 && runs[numRuns - 1].palette == rowMap[x]) {
+                runs[numRuns - 1].width += 8;
+            } else {
+                runs[numRuns].x = (u8) (x * 8);
+                runs[numRuns].width = 8;
+                runs[numRuns].palette = rowMap[x];
+                numRuns++;
+            }
+        }
+
+        this->paletteRunCounts[row] = numRuns;
+        this->paletteRowsDirty &= ~(1U << row);
+    }
+
+    *count = this->paletteRunCounts[row];
+    return this->paletteRuns[row];
+}
+
+void SGB::invalidatePaletteRuns() {
+    this->paletteRowsDirty = (1U << SGB_MAP_HEIGHT) - 1;
+}
+
+void SGB::invalidateBorder() {
+    memset(this->bgDirty, 0xFF, sizeof(this->bgDirty));
+    this->refreshBg();
+}
+
 void SGB::refreshBg() {
     if(this->hasBg && this->gameboy->settings.frameBuffer != nullptr) {
-        for(u8 tileY = 0; tileY < 28; tileY++) {
-            u16* lineMap = (u16*) &this->bgMap[tileY * 32 * sizeof(u16)];
-            for(u8 tileX = 0; tileX < 32; tileX++) {
-                u16 mapEntry = lineMap[tileX];
-                u8* tile = &this->bgTiles[(mapEntry & 0xFF) * 0x20];
-                u16* palette = (u16*) &this->bgMap[0x800 + ((mapEntry >> 10) & 3) * 0x20];
-                bool flipX = (mapEntry & 0x4000) != 0;
-                bool flipY = (mapEntry & 0x8000) != 0;
-
-                for(u8 y = 0; y < 8; y++) {
-                    for(u8 x = 0; x < 8; x++) {
-                        u16 pixelX = tileX * 8 + x;
-                        u16 pixelY = tileY * 8 + y;
-
-                        u8 dataX = flipX ? 7 - x : x;
-                        u8 dataY = flipY ? 7 - y : y;
-                        u8 colorId = (u8) (((tile[dataY * 2] >> (7 - dataX)) & 1) | (((tile[dataY * 2 + 1] >> (7 - dataX)) & 1) << 1) | (((tile[0x10 + dataY * 2] >> (7 - dataX)) & 1) << 2) | (((tile[0x10 + dataY * 2 + 1] >> (7 - dataX)) & 1) << 3));
-
-                        u32 color = 0;
-                        if(colorId != 0) {
-                            color = RGB555ToRGB8888(palette[colorId]);
-                        } else if(pixelX < GB_SCREEN_X || pixelX >= GB_SCREEN_X + GB_SCREEN_WIDTH || pixelY < GB_SCREEN_Y || pixelY >= GB_SCREEN_Y + GB_SCREEN_HEIGHT) {
-                            color = this->gameboy->ppu.getBgPalette()[0];
-                        } else {
-                            continue;
-                        }
+        // Transparent pixels outside of the game screen show color 0, so follow any changes to it.
+        u32 color0 = this->gameboy->ppu.getBgPalette()[0];
+        if(color0 != this->bgColor0) {
+            this->bgColor0 = color0;
+            memset(this->bgDirty, 0xFF, sizeof(this->bgDirty));
+        }
 
-                        this->gameboy->settings.frameBuffer[pixelY * this->gameboy->settings.framePitch + pixelX] = color;
-                    }
+        for(u8 cellY = 0; cellY < SGB_BORDER_TILES_Y; cellY++) {
+            u32 dirty = this->bgDirty[cellY];
+            if(dirty == 0) {
+                continue;
+            }
+
+            for(u8 cellX = 0; cellX < SGB_BORDER_TILES_X; cellX++) {
+                if(dirty & (1U << cellX)) {
+                    this->drawBgCell(cellX, cellY, color0);
                 }
             }
+
+            this->bgDirty[cellY] = 0;
+        }
+    }
+}
+
+void SGB::decodeBgTile(u8 tile) {
+    u8* data = &this->bgTiles[tile * 0x20];
+    u8* pixels = this->bgPixels[tile];
+
+    for(u8 y = 0; y < 8; y++) {
+        u8 plane0 = data[y * 2];
+        u8 plane1 = data[y * 2 + 1];
+        u8 plane2 = data[0x10 + y * 2];
+        u8 plane3 = data[0x10 + y * 2 + 1];
+
+        for(u8 x = 0; x < 8; x++) {
+            u8 shift = (u8) (7 - x);
+            pixels[y * 8 + x] = (u8) (((plane0 >> shift) & 1) | (((plane1 >> shift) & 1) << 1) | (((plane2 >> shift) & 1) << 2) | (((plane3 >> shift) & 1) << 3));
+        }
+    }
+}
+
+void SGB::loadBgPalette(u8 palette) {
+    u16* colors = (u16*) &this->bgMap[0x800 + palette * 0x20];
+    for(u8 i = 0; i < 16; i++) {
+        this->bgPalettes[palette][i] = RGB555ToRGB8888(colors[i]);
+    }
+}
+
+void SGB::markBgTiles(const bool* tiles, const bool* palettes) {
+    for(u8 cellY = 0; cellY < SGB_BORDER_TILES_Y; cellY++) {
+        u16* lineMap = (u16*) &this->bgMap[cellY * SGB_BORDER_TILES_X * sizeof(u16)];
+        for(u8 cellX = 0; cellX < SGB_BORDER_TILES_X; cellX++) {
+            u16 mapEntry = lineMap[cellX];
+            if(tiles[mapEntry & 0xFF] || palettes[(mapEntry >> 10) & 3]) {
+                this->bgDirty[cellY] |= 1U << cellX;
+            }
+        }
+    }
+}
+
+void SGB::drawBgCell(u8 cellX, u8 cellY, u32 color0) {
+    u16 mapEntry = ((u16*) this->bgMap)[cellY * SGB_BORDER_TILES_X + cellX];
+    u8* pixels = this->bgPixels[mapEntry & 0xFF];
+    u32* palette = this->bgPalettes[(mapEntry >> 10) & 3];
+    bool flipX = (mapEntry & 0x4000) != 0;
+    bool flipY = (mapEntry & 0x8000) != 0;
+
+    // The game screen lies on cell boundaries, so a cell is either wholly inside or outside of it.
+    // Inside, transparent pixels are left alone so that the game shows through.
+    bool inScreen = cellX >= GB_SCREEN_X / 8 && cellX < (GB_SCREEN_X + GB_SCREEN_WIDTH) / 8 && cellY >= GB_SCREEN_Y / 8 && cellY < (GB_SCREEN_Y + GB_SCREEN_HEIGHT) / 8;
+
+    u32 pitch = this->gameboy->settings.framePitch;
+    u32* out = &this->gameboy->settings.frameBuffer[cellY * 8 * pitch + cellX * 8];
+    for(u8 y = 0; y < 8; y++) {
+        u8* row = &pixels[(flipY ? 7 - y : y) * 8];
+        for(u8 x = 0; x < 8; x++) {
+            u8 colorId = row[flipX ? 7 - x : x];
+            if(colorId != 0) {
+                out[x] = palette[colorId];
+            } else if(!inScreen) {
+                out[x] = color0;
+            }
         }
+
+        out += pitch;
     }
 }
 
@@ -253,6 +360,8 @@ void SGB::loadAttrFile(u8 index) {
 
         src++;
     }
+
+    this->invalidatePaletteRuns();
 }
 
 // Begin commands
@@ -380,6 +489,8 @@ void SGB::attrBlock() {
             this->cmdData.numDataSets--;
         }
     }
+
+    this->invalidatePaletteRuns();
 }
 
 void SGB::attrLin() {
@@ -406,6 +517,8 @@ void SGB::attrLin() {
             }
         }
     }
+
+    this->invalidatePaletteRuns();
 }
 
 void SGB::attrDiv() {
@@ -450,6 +563,8 @@ void SGB::attrDiv() {
             }
         }
     }
+
+    this->invalidatePaletteRuns();
 }
 
 void SGB::attrChr() {
@@ -491,6 +606,8 @@ void SGB::attrChr() {
         index++;
         this->cmdData.numDataSets--;
     }
+
+    this->invalidatePaletteRuns();
 }
 
 void SGB::sound() {
@@ -565,16 +682,69 @@ void SGB::jump() {
 }
 
 void SGB::chrTrn() {
-    this->gameboy->ppu.transferTiles(&this->bgTiles[(this->packet[1] & 1) * 0x1000]);
+    u8 data[0x1000];
+    this->gameboy->ppu.transferTiles(data);
+
+    // Games often resend the same border, so only redraw the tiles that actually changed.
+    u8 first = (u8) ((this->packet[1] & 1) * 0x80);
+    bool tiles[0x100] = {false};
+    bool palettes[4] = {false};
+    for(u32 i = 0; i < 0x80; i++) {
+        u8* tile = &this->bgTiles[(first + i) * 0x20];
+        if(memcmp(tile, &data[i * 0x20], 0x20) != 0) {
+            memcpy(tile, &data[i * 0x20], 0x20);
+            this->decodeBgTile((u8) (first + i));
+
+            tiles[first + i] = true;
+        }
+    }
+
+    this->markBgTiles(tiles, palettes);
+
+    if(!this->hasBg) {
+        this->hasBg = true;
+        memset(this->bgDirty, 0xFF, sizeof(this->bgDirty));
+    }
 
-    this->hasBg = true;
     this->refreshBg();
 }
 
 void SGB::pctTrn() {
-    this->gameboy->ppu.transferTiles(this->bgMap);
+    u8 data[0x1000];
+    this->gameboy->ppu.transferTiles(data);
+
+    u16* oldMap = (u16*) this->bgMap;
+    u16* newMap = (u16*) data;
+    for(u8 cellY = 0; cellY < SGB_BORDER_TILES_Y; cellY++) {
+        for(u8 cellX = 0; cellX < SGB_BORDER_TILES_X; cellX++) {
+            u32 index = cellY * SGB_BORDER_TILES_X + cellX;
+            if(oldMap[index] != newMap[index]) {
+                this->bgDirty[cellY] |= 1U << cellX;
+            }
+        }
+    }
+
+    bool tiles[0x100] = {false};
+    bool palettes[4] = {false};
+    for(u8 palette = 0; palette < 4; palette++) {
+        palettes[palette] = memcmp(&this->bgMap[0x800 + palette * 0x20], &data[0x800 + palette * 0x20], 0x20) != 0;
+    }
+
+    memcpy(this->bgMap, data, sizeof(this->bgMap));
+
+    for(u8 palette = 0; palette < 4; palette++) {
+        if(palettes[palette]) {
+            this->loadBgPalette(palette);
+        }
+    }
+
+    this->markBgTiles(tiles, palettes);
+
+    if(!this->hasBg) {
+        this->hasBg = true;
+        memset(this->bgDirty, 0xFF, sizeof(this->bgDirty));
+    }
 
-    this->hasBg = true;
     this->refreshBg();
 }
 